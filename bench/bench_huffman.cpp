@@ -0,0 +1,288 @@
+#include "../src/block_codec.h"
+#include "../src/cpu_dispatch.h"
+#include "../src/huffman_context.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Corpus {
+    std::string name;
+    std::vector<unsigned char> data;
+};
+
+std::vector<unsigned char> makeLog(size_t size, std::mt19937& rng) {
+    static const char* kLevels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+    static const char* kMessages[] = {"request served", "cache miss", "connection closed by peer", "retrying upload", "user logged in"};
+    std::vector<unsigned char> data;
+    while (data.size() < size) {
+        std::string line = "2024-05-" + std::to_string(10 + rng() % 20) + " 12:" + std::to_string(10 + rng() % 50) + " [" +
+                           kLevels[rng() % 6] + "] worker-" + std::to_string(rng() % 16) + ": " + kMessages[rng() % 5] + " id=" +
+                           std::to_string(rng() % 100000) + "\n";
+        data.insert(data.end(), line.begin(), line.end());
+    }
+    data.resize(size);
+    return data;
+}
+
+std::vector<unsigned char> makeBinary(size_t size, std::mt19937& rng) {
+    std::vector<unsigned char> data(size);
+    std::geometric_distribution<int> small(0.05);
+    for (size_t i = 0; i < size; i += 4) {
+        uint32_t value = static_cast<uint32_t>(small(rng));
+        for (size_t k = 0; k < 4 && i + k < size; ++k) data[i + k] = static_cast<unsigned char>(value >> (8 * k));
+    }
+    return data;
+}
+
+std::vector<unsigned char> makeRandom(size_t size, std::mt19937& rng) {
+    std::vector<unsigned char> data(size);
+    for (auto& byte : data) byte = static_cast<unsigned char>(rng());
+    return data;
+}
+
+std::vector<unsigned char> makeMixed(size_t size, std::mt19937& rng) {
+    std::vector<unsigned char> data;
+    while (data.size() < size) {
+        size_t chunk = 24 * 1024 + rng() % (96 * 1024);
+        std::vector<unsigned char> part;
+        switch (rng() % 3) {
+        case 0: part = makeLog(chunk, rng); break;
+        case 1: part = makeBinary(chunk, rng); break;
+        default: part = makeRandom(chunk / 4, rng); break;
+        }
+        data.insert(data.end(), part.begin(), part.end());
+    }
+    data.resize(size);
+    return data;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<unsigned char> makeGeometric(size_t size, double ratio, std::mt19937& rng) {
+    std::vector<double> weights(256);
+    double weight = 1.0;
+    for (auto& w : weights) {
+        w = weight;
+        weight *= ratio;
+    }
+    std::discrete_distribution<int> symbol(weights.begin(), weights.end());
+    std::vector<unsigned char> data(size);
+    for (auto& byte : data) byte = static_cast<unsigned char>(symbol(rng));
+    return data;
+}
+
+int benchKernels() {
+    const size_t size = 16 << 20;
+    const int rounds = 5;
+    std::mt19937 rng(42);
+    struct Sample {
+        std::unique_ptr<CodeTable> table;
+        std::vector<unsigned char> data;
+        std::vector<unsigned char> encoded;
+    };
+    std::vector<Sample> samples;
+    for (unsigned target : {8u, 10u, 11u, 12u}) {
+        Sample sample;
+        // Подбираем крутизну геометрического распределения под нужную максимальную длину кода.
+        for (double ratio = 0.999; ratio > 0.3; ratio -= 0.002) {
+            sample.data = makeGeometric(1 << 20, ratio, rng);
+            sample.table = std::make_unique<CodeTable>();
+            countHistogram(sample.data.data(), sample.data.size(), sample.table->freq);
+            sample.table->build();
+            if (sample.table->table_bits == target) break;
+        }
+        if (sample.table->table_bits != target) continue;
+        sample.data.resize(size);
+        for (size_t i = 1 << 20; i < size; ++i) sample.data[i] = sample.data[i % (1 << 20)];
+        sample.encoded.resize(CodeTable::encodedBound(size));
+        samples.push_back(std::move(sample));
+    }
+
+    const KernelSet detected = detectKernelSet();
+    std::printf("%-8s %10s %10s %8s %14s %14s %14s\n", "kernels", "table bits", "max length", "bits/sym", "histogram MB/s", "encode MB/s",
+                "decode MB/s");
+    for (KernelSet set : {KernelSet::Generic, KernelSet::Sse42, KernelSet::Avx2}) {
+        if (!kernelSetSupported(set)) continue;
+        setKernelSet(set);
+        for (auto& sample : samples) {
+            uint64_t counts[256] = {};
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < rounds; ++i) countHistogram(sample.data.data(), size, counts);
+            double histogram_time = secondsSince(start);
+
+            size_t encoded_size = 0;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < rounds; ++i) encoded_size = sample.table->encodeBits(sample.data.data(), size, sample.encoded.data());
+            double encode_time = secondsSince(start);
+
+            std::vector<unsigned char> restored(size);
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < rounds; ++i) sample.table->decodeBits(sample.encoded.data(), encoded_size, restored.data(), size);
+            double decode_time = secondsSince(start);
+            if (restored != sample.data) {
+                std::fprintf(stderr, "Error: kernel mismatch for %s, %u table bits\n", kernelSetName(set), sample.table->table_bits);
+                return 1;
+            }
+
+            double megabytes = rounds * size / 1e6;
+            std::printf("%-8s %10u %10u %8.3f %14.1f %14.1f %14.1f\n", kernelSetName(set), sample.table->table_bits, sample.table->max_length,
+                        encoded_size * 8.0 / size, megabytes / histogram_time, megabytes / encode_time, megabytes / decode_time);
+        }
+    }
+    setKernelSet(detected);
+
+    // Маленькие блоки: построение таблицы по этапам в сравнении с декодированием.
+    std::printf("\n%-10s %10s %10s %12s %12s %12s %12s\n", "block size", "table bits", "max length", "lengths ns", "codes ns",
+                "table ns", "decode ns");
+    const Sample& sample = samples.back();
+    auto table = std::make_unique<CodeTable>();
+    std::vector<unsigned char> encoded(CodeTable::encodedBound(size));
+    std::vector<unsigned char> restored(size);
+    for (size_t block : {64u, 256u, 1024u, 4096u, 16384u, 65536u}) {
+        uint64_t counts[256] = {};
+        countHistogram(sample.data.data(), block, counts);
+        std::memcpy(table->freq, counts, sizeof(counts));
+        table->build();
+        const int calls = static_cast<int>(std::max<size_t>(200, (64u << 20) / block / 8));
+        double stage_ns[4];
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) table->buildLengths();
+        stage_ns[0] = secondsSince(start) * 1e9 / calls;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) table->buildCodes();
+        stage_ns[1] = secondsSince(start) * 1e9 / calls;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) table->buildDecodeTable();
+        stage_ns[2] = secondsSince(start) * 1e9 / calls;
+
+        size_t encoded_size = table->encodeBits(sample.data.data(), block, encoded.data());
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) table->decodeBits(encoded.data(), encoded_size, restored.data(), block);
+        stage_ns[3] = secondsSince(start) * 1e9 / calls;
+        if (!std::equal(restored.begin(), restored.begin() + block, sample.data.begin())) {
+            std::fprintf(stderr, "Error: small block mismatch for %zu bytes\n", block);
+            return 1;
+        }
+        std::printf("%-10zu %10u %10u %12.0f %12.0f %12.0f %12.0f\n", block, table->table_bits, table->max_length, stage_ns[0],
+                    stage_ns[1], stage_ns[2], stage_ns[3]);
+    }
+    return 0;
+}
+
+}
+
+int benchBatch() {
+    std::mt19937 rng(42);
+    std::vector<unsigned char> log = makeLog(16 << 20, rng);
+    std::vector<BatchInput> records;
+    std::uniform_int_distribution<size_t> record_size(64, 1024);
+    for (size_t pos = 0; pos < log.size();) {
+        size_t size = std::min(record_size(rng), log.size() - pos);
+        records.push_back({log.data() + pos, size});
+        pos += size;
+    }
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    std::printf("%zu records, %zu bytes\n%-36s %12s %8s %14s\n", records.size(), log.size(), "mode", "compressed", "ratio", "compress MB/s");
+    auto report = [&](const char* mode, size_t compressed, double seconds) {
+        std::printf("%-36s %12zu %8.3f %14.1f\n", mode, compressed, double(compressed) / log.size(), log.size() / seconds / 1e6);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<unsigned char>> archives;
+    for (const auto& record : records) archives.push_back(archiver.compressBuffer(record.data, record.size, options));
+    double loop_time = secondsSince(start);
+    size_t compressed = 0;
+    for (const auto& archive : archives) compressed += archive.size();
+    report("compressBuffer loop", compressed, loop_time);
+
+    BatchOutput output;
+    for (unsigned threads : {1u, 0u}) {
+        for (bool shared : {false, true}) {
+            options.threads = threads;
+            output = BatchOutput();
+            start = std::chrono::steady_clock::now();
+            archiver.compressBatch(records.data(), records.size(), &output, options, shared);
+            double seconds = secondsSince(start);
+            std::string mode = std::string("compressBatch") + (threads ? ", 1 thread" : ", all threads") + (shared ? ", shared" : "");
+            report(mode.c_str(), output.arena.size(), seconds);
+        }
+    }
+
+    if (output.dictionary) archiver.addDictionary(output.dictionary);
+    for (size_t i = 0; i < records.size(); i += 997) {
+        std::vector<unsigned char> restored = archiver.decompressBuffer(output.arena.data() + output.offsets[i], output.offsets[i + 1] - output.offsets[i]);
+        if (!std::equal(restored.begin(), restored.end(), records[i].data, records[i].data + records[i].size)) {
+            std::fprintf(stderr, "Error: batch record %zu mismatch\n", i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--kernels") return benchKernels();
+    if (argc == 2 && std::string(argv[1]) == "--batch") return benchBatch();
+
+    std::vector<Corpus> corpora;
+    try {
+        if (argc > 1) {
+            for (int i = 1; i < argc; ++i) {
+                std::ifstream in(argv[i], std::ios::binary);
+                if (!in) throw std::runtime_error(std::string("Failed to open input file: ") + argv[i]);
+                corpora.push_back({argv[i], std::vector<unsigned char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>())});
+            }
+        } else {
+            const size_t size = 16 << 20;
+            std::mt19937 rng(42);
+            corpora.push_back({"log", makeLog(size, rng)});
+            corpora.push_back({"binary", makeBinary(size, rng)});
+            corpora.push_back({"random", makeRandom(size, rng)});
+            corpora.push_back({"mixed", makeMixed(size, rng)});
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    HuffmanContext context;
+    std::printf("%-12s %5s %12s %8s %14s %14s\n", "corpus", "level", "compressed", "ratio", "compress MB/s", "decompress MB/s");
+    for (const auto& corpus : corpora) {
+        if (corpus.data.empty()) continue;
+        std::vector<unsigned char> restored(corpus.data.size());
+        for (int level = 1; level <= 9; ++level) {
+            CompressOptions options = CompressOptions::fromLevel(level);
+            std::vector<unsigned char> archive(HuffmanContext::compressBound(corpus.data.size(), options.block_size));
+
+            auto start = std::chrono::steady_clock::now();
+            size_t compressed = context.compress(corpus.data.data(), corpus.data.size(), archive.data(), archive.size(), options);
+            double compress_time = secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            size_t restored_size = context.decompress(archive.data(), compressed, restored.data(), restored.size());
+            double decompress_time = secondsSince(start);
+            if (restored_size != corpus.data.size() || restored != corpus.data) {
+                std::fprintf(stderr, "Error: roundtrip mismatch on %s at level %d\n", corpus.name.c_str(), level);
+                return 1;
+            }
+
+            double megabytes = corpus.data.size() / 1e6;
+            std::printf("%-12s %5d %12zu %8.4f %14.1f %14.1f\n", corpus.name.c_str(), level, compressed,
+                        static_cast<double>(compressed) / corpus.data.size(), megabytes / compress_time, megabytes / decompress_time);
+        }
+    }
+    return 0;
+}
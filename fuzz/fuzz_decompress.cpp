@@ -0,0 +1,26 @@
+// Цель для libFuzzer: распаковка произвольных данных в памяти не должна падать,
+// читать за границы буферов или выделять память сверх kMaxOutput.
+#include "../src/huffman_context.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kMaxOutput = 64 << 20;
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static HuffmanContext context;
+    static std::vector<unsigned char> out;
+    try {
+        uint64_t content_size = HuffmanContext::contentSize(data, size);
+        if (content_size > kMaxOutput) return 0;
+        out.resize(static_cast<size_t>(content_size));
+        context.decompress(data, size, out.data(), out.size());
+    } catch (const std::runtime_error&) {
+    }
+    return 0;
+}
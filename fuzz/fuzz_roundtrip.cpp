@@ -0,0 +1,30 @@
+// Цель для libFuzzer: сжатие с параметрами из первого байта и распаковка
+// должны вернуть исходные данные; расхождение завершает процесс через abort().
+#include "../src/huffman_context.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 2) return 0;
+    static HuffmanContext context;
+    static std::vector<unsigned char> archive;
+    static std::vector<unsigned char> restored;
+
+    CompressOptions options = CompressOptions::fromLevel(1 + data[0] % 9);
+    options.block_size = size_t(1) << (8 + (data[0] >> 4) % 13);
+    options.seek_index = data[0] & 0x08;
+    options.wide_symbols = data[0] & 0x04;
+    data++;
+    size--;
+
+    archive.resize(HuffmanContext::compressBound(size, options.block_size));
+    size_t compressed = context.compress(data, size, archive.data(), archive.size(), options);
+    if (HuffmanContext::contentSize(archive.data(), compressed) != size) std::abort();
+    restored.resize(size);
+    if (context.decompress(archive.data(), compressed, restored.data(), restored.size()) != size) std::abort();
+    if (std::memcmp(restored.data(), data, size) != 0) std::abort();
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Прогон корпуса через цель фаззинга без libFuzzer: используется в ctest, чтобы
+// найденные ранее входы и замедления ловились обычной сборкой.
+// Использование: <replay> [-max_ms=N] <файл|каталог>...
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[]) {
+    double max_ms = 1000;
+    std::vector<fs::path> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("-max_ms=", 0) == 0) {
+            max_ms = std::stod(arg.substr(8));
+        } else if (fs::is_directory(arg)) {
+            for (const auto& entry : fs::directory_iterator(arg)) {
+                if (entry.is_regular_file()) inputs.push_back(entry.path());
+            }
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        std::fprintf(stderr, "Usage: %s [-max_ms=N] <file|directory>...\n", argv[0]);
+        return 1;
+    }
+
+    int slow = 0;
+    for (const auto& path : inputs) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto start = std::chrono::steady_clock::now();
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ms > max_ms) {
+            std::fprintf(stderr, "Slow input: %s (%zu bytes, %.1f ms > %.1f ms)\n", path.string().c_str(), data.size(), ms, max_ms);
+            ++slow;
+        }
+    }
+    std::printf("Replayed %zu inputs, %d over budget\n", inputs.size(), slow);
+    return slow == 0 ? 0 : 1;
+}
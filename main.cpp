@@ -1,32 +1,313 @@
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <vector>
 #include <filesystem>
+#include <chrono>
 #include "src/huffman.h"
+#include "src/container.h"
+#include "src/dictionary.h"
+#include "src/probe.h"
+#include "src/block_codec.h"
+#include "src/cpu_dispatch.h"
+#include "src/adaptive_stream.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
 
 namespace fs = std::filesystem;
 
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <command> <file> [output_file] [options]\n";
+    std::cerr << "       " << program << " compress -r <directory> [archive] [options]\n";
+    std::cerr << "       " << program << " compress-many <list_file|directory> [options]\n";
+    std::cerr << "       " << program << " pack <archive> <file>... [options]\n";
+    std::cerr << "       " << program << " list <archive>\n";
+    std::cerr << "       " << program << " verify <archive> [options]\n";
+    std::cerr << "       " << program << " probe <file>... [--block-size <B>]\n";
+    std::cerr << "       " << program << " extract <archive> [output_file] --offset <X> --length <N> [--member <name>]\n";
+    std::cerr << "       " << program << " train <dictionary_file> <sample_file|directory>... [--dict-id <id>]\n";
+    std::cerr << "Commands: compress, decompress, decompress_with_freq, compress-many, pack, list, verify, extract, probe, train\n";
+    std::cerr << "Options:\n";
+    std::cerr << "  -1 .. -9            compression level: faster (-1) to denser (-9) (default: -6)\n";
+    std::cerr << "  -j <N>              number of worker threads (default: all cores)\n";
+    std::cerr << "  --block-size <B>    block size in bytes (default: 1048576)\n";
+    std::cerr << "  --no-split          use fixed-size blocks instead of adaptive splitting\n";
+    std::cerr << "  -r                  compress: pack a directory tree into one container (extract with decompress)\n";
+    std::cerr << "  --wide              compress: also try 16-bit symbols per block (UTF-16, int16 samples)\n";
+    std::cerr << "  --adaptive          compress: one-pass adaptive stream (table rebuilt every --rebuild-interval bytes)\n";
+    std::cerr << "  --rebuild-interval <B>  adaptive table rebuild interval in bytes (default: 16384)\n";
+    std::cerr << "  --member <name>     decompress: extract a single member of a container\n";
+    std::cerr << "  --dict <file>       compress/decompress with a trained dictionary\n";
+    std::cerr << "  --stats             compress/decompress: print time, throughput, memory budget and kernel set\n";
+    std::cerr << "  --cpu=<set>         kernel set: auto, generic, sse4.2, avx2 (default: auto)\n";
+    std::cerr << "  --offset <X>        extract: first byte of the range in the original content\n";
+    std::cerr << "  --length <N>        extract: number of bytes to extract (default: up to the end)\n";
+}
+
+static void printStats(const std::string& input_file, const std::string& output_file, double seconds, uint64_t memory_budget) {
+    uint64_t input_size = fs::file_size(input_file);
+    uint64_t output_size = fs::file_size(output_file);
+    std::cout << "Stats: " << input_size << " -> " << output_size << " bytes, " << seconds * 1000 << " ms, "
+              << (seconds > 0 ? std::max(input_size, output_size) / seconds / 1e6 : 0) << " MB/s\n";
+    std::cout << "Memory budget: " << memory_budget << " bytes";
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    std::cout << ", peak RSS " << usage.ru_maxrss / 1024 << " KiB";
+#else
+    std::cout << ", peak RSS " << usage.ru_maxrss << " KiB";
+#endif
+#endif
+    std::cout << "\n";
+    std::cout << "Kernels: " << kernelSetName(activeKernelSet()) << "\n";
+}
+
+static uint32_t archiveBlockSize(const std::string& archive) {
+    std::ifstream in(archive, std::ios::binary);
+    unsigned char header[frame::kHeaderSize];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) throw std::runtime_error("Archive is empty or corrupted");
+    return frame::readHeader(header).block_size;
+}
+
+static void compressAdaptive(const std::string& input_file, const std::string& output_file, size_t rebuild_interval) {
+    std::ifstream in(input_file, std::ios::binary);
+    std::ofstream out(output_file, std::ios::binary);
+    if (!in || !out) throw std::runtime_error("Error opening files");
+    AdaptiveEncoder encoder(out, rebuild_interval);
+    std::vector<char> buffer(1 << 16);
+    while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+        encoder.write(reinterpret_cast<const unsigned char*>(buffer.data()), static_cast<size_t>(in.gcount()));
+    }
+    encoder.finish();
+}
+
+static size_t decompressAdaptive(const std::string& input_file, const std::string& output_file) {
+    std::ifstream in(input_file, std::ios::binary);
+    std::ofstream out(output_file, std::ios::binary);
+    if (!in || !out) throw std::runtime_error("Error opening files");
+    AdaptiveDecoder decoder(in);
+    std::vector<unsigned char> buffer(1 << 16);
+    while (size_t size = decoder.read(buffer.data(), buffer.size())) {
+        if (!out.write(reinterpret_cast<const char*>(buffer.data()), size)) throw std::runtime_error("Failed to write output file");
+    }
+    return decoder.getRebuildInterval();
+}
+
+static std::vector<std::string> collectInputFiles(const std::string& source) {
+    std::vector<std::string> files;
+    if (fs::is_directory(source)) {
+        for (const auto& entry : fs::directory_iterator(source)) {
+            if (entry.is_regular_file() && entry.path().extension() != ".huff") {
+                files.push_back(entry.path().string());
+            }
+        }
+        return files;
+    }
+    std::ifstream list(source);
+    if (!list) throw std::runtime_error("Failed to open file list");
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) files.push_back(line);
+    }
+    return files;
+}
+
+static std::string memberName(const std::string& file) {
+    fs::path path = fs::path(file).lexically_normal();
+    if (path.is_relative()) {
+        bool escapes = false;
+        for (const auto& part : path) escapes = escapes || part == "..";
+        if (!escapes) return path.generic_string();
+    }
+    return path.filename().generic_string();
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <command> <file> [output_file]\n";
-        std::cerr << "Commands: compress, decompress, decompress_with_freq\n";
+    std::vector<std::string> args;
+    CompressOptions options;
+    std::string member;
+    std::string dictionary_file;
+    uint32_t dictionary_id = 0;
+    uint64_t range_offset = 0;
+    uint64_t range_length = UINT64_MAX;
+    bool stats = false;
+    std::string kernel_set;
+    bool adaptive = false;
+    bool recursive = false;
+    size_t rebuild_interval = kDefaultRebuildInterval;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.size() == 2 && arg[0] == '-' && arg[1] >= '1' && arg[1] <= '9') {
+                options = CompressOptions::fromLevel(arg[1] - '0');
+            }
+        }
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.size() == 2 && arg[0] == '-' && arg[1] >= '1' && arg[1] <= '9') {
+                continue;
+            } else if (arg == "-j" && i + 1 < argc) {
+                options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "--block-size" && i + 1 < argc) {
+                options.block_size = std::stoull(argv[++i]);
+            } else if (arg == "--stats") {
+                stats = true;
+            } else if (arg.rfind("--cpu=", 0) == 0) {
+                kernel_set = arg.substr(6);
+            } else if (arg == "-r") {
+                recursive = true;
+            } else if (arg == "--wide") {
+                options.wide_symbols = true;
+            } else if (arg == "--adaptive") {
+                adaptive = true;
+            } else if (arg == "--rebuild-interval" && i + 1 < argc) {
+                rebuild_interval = std::stoull(argv[++i]);
+            } else if (arg == "--no-split") {
+                options.adaptive_split = false;
+            } else if (arg == "--member" && i + 1 < argc) {
+                member = argv[++i];
+            } else if (arg == "--dict" && i + 1 < argc) {
+                dictionary_file = argv[++i];
+            } else if (arg == "--offset" && i + 1 < argc) {
+                range_offset = std::stoull(argv[++i]);
+            } else if (arg == "--length" && i + 1 < argc) {
+                range_length = std::stoull(argv[++i]);
+            } else if (arg == "--dict-id" && i + 1 < argc) {
+                dictionary_id = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (args.size() < 2) {
+        printUsage(argv[0]);
         return 1;
     }
 
-    std::string command = argv[1];
-    std::string input_file = argv[2];
-    std::string output_file = argc > 3 ? argv[3] : (command == "compress" ? input_file + ".huff" : fs::path(input_file).stem().string() + "_decomp" + fs::path(input_file).extension().string());
+    std::string command = args[0];
+    std::string input_file = args[1];
+    std::string output_file = args.size() > 2 ? args[2] : (command == "compress" ? input_file + ".huff" : fs::path(input_file).stem().string() + "_decomp" + fs::path(input_file).extension().string());
 
     HuffmanArchiver archiver;
     try {
-        if (command == "compress") {
-            archiver.compress(input_file, output_file);
+        if (!kernel_set.empty()) setKernelSet(parseKernelSet(kernel_set));
+        if (!dictionary_file.empty() && command != "train") {
+            auto dictionary = std::make_shared<const Dictionary>(Dictionary::load(dictionary_file));
+            archiver.addDictionary(dictionary);
+            options.dictionary = dictionary;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+        if (command == "compress" && recursive) {
+            fs::path root = fs::path(input_file).lexically_normal();
+            if (!root.has_filename()) root = root.parent_path();
+            std::string archive = args.size() > 2 ? args[2] : root.string() + ".huffa";
+            ArchiveWriter writer(archive);
+            writer.addTree(input_file, options);
+            writer.finish();
+            std::cout << "Packed " << writer.getEntries().size() << " files: " << archive << "\n";
+        } else if (command == "compress" && adaptive) {
+            compressAdaptive(input_file, output_file, rebuild_interval);
+            std::cout << "Compression completed: " << output_file << "\n";
+            if (stats) printStats(input_file, output_file, elapsed(), adaptiveMemoryBudget(rebuild_interval));
+        } else if (command == "decompress" && AdaptiveDecoder::isAdaptiveStream(input_file)) {
+            size_t interval = decompressAdaptive(input_file, output_file);
+            std::cout << "Decompression completed: " << output_file << "\n";
+            if (stats) printStats(input_file, output_file, elapsed(), adaptiveMemoryBudget(interval));
+        } else if (command == "compress") {
+            archiver.compress(input_file, output_file, options);
             std::cout << "Compression completed: " << output_file << "\n";
+            if (stats) printStats(input_file, output_file, elapsed(), HuffmanArchiver::compressMemoryBudget(options));
+        } else if (command == "decompress" && ArchiveReader::isContainer(input_file)) {
+            ArchiveReader reader(input_file);
+            if (options.dictionary) reader.addDictionary(options.dictionary);
+            if (member.empty()) {
+                std::string directory = args.size() > 2 ? args[2] : ".";
+                reader.extractAll(directory, options.threads);
+                std::cout << "Extracted " << reader.getEntries().size() << " members to " << directory << "\n";
+            } else {
+                std::string target = args.size() > 2 ? args[2] : fs::path(member).filename().string();
+                reader.extract(member, target);
+                std::cout << "Extracted " << member << ": " << target << "\n";
+            }
         } else if (command == "decompress") {
             archiver.decompress(input_file, output_file);
             std::cout << "Decompression completed: " << output_file << "\n";
+            if (stats) printStats(input_file, output_file, elapsed(), HuffmanArchiver::decompressMemoryBudget(archiveBlockSize(input_file)));
         } else if (command == "decompress_with_freq") {
             archiver.decompress(input_file, output_file, true);
             std::cout << "Decompression with frequencies completed: " << output_file << "\n";
+        } else if (command == "compress-many") {
+            std::vector<std::string> files = collectInputFiles(input_file);
+            std::vector<FileError> errors = archiver.compressMany(files, options);
+            for (const auto& error : errors) {
+                std::cerr << "Error: " << error.path << ": " << error.message << "\n";
+            }
+            std::cout << "Compressed " << files.size() - errors.size() << " of " << files.size() << " files\n";
+            return errors.empty() ? 0 : 1;
+        } else if (command == "pack") {
+            ArchiveWriter writer(input_file);
+            for (size_t i = 2; i < args.size(); ++i) {
+                writer.add(args[i], memberName(args[i]), options);
+            }
+            writer.finish();
+            std::cout << "Packed " << writer.getEntries().size() << " files: " << input_file << "\n";
+        } else if (command == "train") {
+            std::vector<std::string> samples;
+            for (size_t i = 2; i < args.size(); ++i) {
+                if (fs::is_directory(args[i])) {
+                    std::vector<std::string> files = collectInputFiles(args[i]);
+                    samples.insert(samples.end(), files.begin(), files.end());
+                } else {
+                    samples.push_back(args[i]);
+                }
+            }
+            if (samples.empty()) throw std::runtime_error("No sample files given");
+            Dictionary dictionary = Dictionary::train(samples, dictionary_id);
+            dictionary.save(input_file);
+            std::cout << "Dictionary " << dictionary.getId() << " trained on " << samples.size() << " files: " << input_file << "\n";
+        } else if (command == "verify" && ArchiveReader::isContainer(input_file)) {
+            ArchiveReader reader(input_file);
+            if (options.dictionary) reader.addDictionary(options.dictionary);
+            reader.verify(options.threads);
+            std::cout << "Archive OK: " << reader.getEntries().size() << " members\n";
+        } else if (command == "verify") {
+            uint64_t size = archiver.verify(input_file, options.threads);
+            std::cout << "Archive OK: " << size << " bytes\n";
+        } else if (command == "extract") {
+            uint64_t written;
+            if (!member.empty()) {
+                ArchiveReader reader(input_file);
+                if (options.dictionary) reader.addDictionary(options.dictionary);
+                output_file = args.size() > 2 ? args[2] : fs::path(member).filename().string();
+                written = reader.extractRange(member, range_offset, range_length, output_file);
+            } else {
+                written = archiver.extractRange(input_file, range_offset, range_length, output_file);
+            }
+            std::cout << "Extracted " << written << " bytes: " << output_file << "\n";
+        } else if (command == "probe") {
+            ProbeOptions probe_options;
+            probe_options.block_size = options.block_size;
+            for (size_t i = 1; i < args.size(); ++i) {
+                ProbeResult result = probeFile(args[i], probe_options);
+                std::cout << args[i] << ": " << result.size << " -> ~" << result.estimated_size << " bytes (ratio " << result.ratio
+                          << ", entropy " << result.entropy << " bits/byte)\n";
+            }
+        } else if (command == "list") {
+            ArchiveReader reader(input_file);
+            for (const auto& entry : reader.getEntries()) {
+                std::cout << entry.size << "\t" << entry.compressed_size << "\t" << entry.name << "\n";
+            }
         } else {
             std::cerr << "Unknown command: " << command << "\n";
             return 1;
@@ -37,4 +318,4 @@ int main(int argc, char* argv[]) {
     }
 
     return 0;
-}
\ No newline at end of file
+}
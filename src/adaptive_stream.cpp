@@ -0,0 +1,159 @@
+#include "adaptive_stream.h"
+#include "checksum.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+bool validInterval(uint64_t interval) {
+    return interval >= kMinRebuildInterval && interval <= kMaxRebuildInterval;
+}
+
+size_t readAdaptiveHeader(std::istream& in) {
+    unsigned char header[kAdaptiveHeaderSize];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) throw std::runtime_error("Stream is empty or corrupted");
+    if (frame::getU32(header) != kAdaptiveMagic) throw std::runtime_error("Not an adaptive stream");
+    if (header[4] != kAdaptiveVersion) throw std::runtime_error("Unsupported adaptive stream version");
+    uint32_t interval = frame::getU32(header + 5);
+    if (!validInterval(interval)) throw std::runtime_error("Corrupted stream: invalid rebuild interval");
+    return interval;
+}
+
+}
+
+AdaptiveModel::AdaptiveModel(size_t interval) : table(std::make_unique<CodeTable>()), interval(interval) {
+    if (!validInterval(interval)) throw std::runtime_error("Invalid rebuild interval");
+    std::fill(table->freq, table->freq + 256, 1);
+    table->build();
+    std::fill(counts, counts + 256, 0);
+}
+
+void AdaptiveModel::update(const unsigned char* data, size_t size) {
+    countHistogram(data, size, counts);
+    since_rebuild += size;
+    if (since_rebuild < interval) return;
+    for (int s = 0; s < 256; ++s) {
+        table->freq[s] = counts[s] + 1;
+        counts[s] >>= 1;
+    }
+    table->build();
+    since_rebuild = 0;
+}
+
+AdaptiveEncoder::AdaptiveEncoder(std::ostream& out, size_t rebuild_interval) : out(out), model(rebuild_interval) {
+    pending.reserve(rebuild_interval);
+    encoded.resize(frame::kBlockHeaderSize + CodeTable::encodedBound(rebuild_interval));
+
+    unsigned char header[kAdaptiveHeaderSize];
+    frame::putU32(header, kAdaptiveMagic);
+    header[4] = kAdaptiveVersion;
+    frame::putU32(header + 5, static_cast<uint32_t>(rebuild_interval));
+    if (!out.write(reinterpret_cast<const char*>(header), sizeof(header))) throw std::runtime_error("Failed to write output stream");
+}
+
+void AdaptiveEncoder::emitFrame() {
+    if (pending.empty()) return;
+    const size_t size = pending.size();
+    unsigned char* payload = encoded.data() + frame::kBlockHeaderSize;
+
+    frame::BlockHeader header;
+    header.raw_size = static_cast<uint32_t>(size);
+    header.checksum = crc32c(0, pending.data(), size);
+    size_t payload_size = model.getTable().encodeBits(pending.data(), size, payload);
+    if (payload_size >= size) {
+        header.mode = frame::BlockMode::Stored;
+        std::memcpy(payload, pending.data(), size);
+        payload_size = size;
+    }
+    header.payload_size = static_cast<uint32_t>(payload_size);
+    frame::writeBlockHeader(header, encoded.data());
+    if (!out.write(reinterpret_cast<const char*>(encoded.data()), frame::kBlockHeaderSize + payload_size)) {
+        throw std::runtime_error("Failed to write output stream");
+    }
+
+    content_checksum = crc32cCombine(content_checksum, header.checksum, size);
+    model.update(pending.data(), size);
+    pending.clear();
+}
+
+void AdaptiveEncoder::write(const unsigned char* data, size_t size) {
+    if (finished) throw std::runtime_error("Adaptive stream is already finished");
+    while (size > 0) {
+        size_t length = std::min(size, model.remaining() - pending.size());
+        pending.insert(pending.end(), data, data + length);
+        data += length;
+        size -= length;
+        if (pending.size() == model.remaining()) emitFrame();
+    }
+}
+
+void AdaptiveEncoder::flush() {
+    emitFrame();
+    if (!out.flush()) throw std::runtime_error("Failed to write output stream");
+}
+
+void AdaptiveEncoder::finish() {
+    if (finished) return;
+    emitFrame();
+    frame::BlockHeader end;
+    end.mode = frame::BlockMode::Stored;
+    end.checksum = content_checksum;
+    unsigned char header[frame::kBlockHeaderSize];
+    frame::writeBlockHeader(end, header);
+    if (!out.write(reinterpret_cast<const char*>(header), sizeof(header)) || !out.flush()) {
+        throw std::runtime_error("Failed to write output stream");
+    }
+    finished = true;
+}
+
+AdaptiveDecoder::AdaptiveDecoder(std::istream& in) : in(in), model(readAdaptiveHeader(in)) {}
+
+bool AdaptiveDecoder::isAdaptiveStream(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char magic[4];
+    return in.read(reinterpret_cast<char*>(magic), sizeof(magic)) && frame::getU32(magic) == kAdaptiveMagic;
+}
+
+void AdaptiveDecoder::readFrame() {
+    unsigned char buffer[frame::kBlockHeaderSize];
+    if (!in.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) throw std::runtime_error("Corrupted stream: unexpected end of stream");
+    frame::BlockHeader header = frame::readBlockHeader(buffer);
+    if (header.raw_size == 0) {
+        if (header.payload_size != 0) throw std::runtime_error("Corrupted stream: invalid end marker");
+        if (header.checksum != content_checksum) throw std::runtime_error("Corrupted stream: content checksum mismatch");
+        finished = true;
+        return;
+    }
+    if (header.raw_size > model.remaining()) throw std::runtime_error("Corrupted stream: frame crosses table rebuild");
+    if (header.mode == frame::BlockMode::Stored) {
+        if (header.payload_size != header.raw_size) throw std::runtime_error("Corrupted stream: invalid stored frame");
+    } else if (header.mode == frame::BlockMode::Huffman) {
+        if (header.payload_size > CodeTable::encodedBound(header.raw_size)) throw std::runtime_error("Corrupted stream: payload is too large");
+    } else {
+        throw std::runtime_error("Corrupted stream: unsupported frame mode");
+    }
+
+    payload.resize(header.payload_size);
+    if (!in.read(reinterpret_cast<char*>(payload.data()), payload.size())) throw std::runtime_error("Corrupted stream: unexpected end of stream");
+    decoded.resize(header.raw_size);
+    if (header.mode == frame::BlockMode::Stored) {
+        std::memcpy(decoded.data(), payload.data(), payload.size());
+    } else {
+        model.getTable().decodeBits(payload.data(), payload.size(), decoded.data(), decoded.size());
+    }
+    if (crc32c(0, decoded.data(), decoded.size()) != header.checksum) throw std::runtime_error("Corrupted stream: frame checksum mismatch");
+
+    content_checksum = crc32cCombine(content_checksum, header.checksum, decoded.size());
+    model.update(decoded.data(), decoded.size());
+    position = 0;
+}
+
+size_t AdaptiveDecoder::read(unsigned char* data, size_t capacity) {
+    if (capacity == 0) return 0;
+    while (position == decoded.size() && !finished) readFrame();
+    size_t length = std::min(capacity, decoded.size() - position);
+    std::memcpy(data, decoded.data() + position, length);
+    position += length;
+    return length;
+}
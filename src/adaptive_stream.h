@@ -0,0 +1,238 @@
+#pragma once
+#include "block_codec.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @file adaptive_stream.h
+ * @brief Однопроходное адаптивное сжатие потоков, которые нельзя перечитать (сокеты, каналы).
+ *
+ * Кодировщик и декодер ведут одинаковую модель: таблица кодов строится по накопленной
+ * гистограмме и перестраивается каждые rebuild_interval байт исходных данных. Перестроение
+ * детерминировано, поэтому таблицы в поток не пишутся. До первого перестроения все
+ * символы кодируются 8 битами.
+ *
+ * Раскладка (все числа little-endian): магическое число "HUFS", версия (1 байт),
+ * интервал перестроения (uint32), затем кадры с заголовком блока frame::BlockHeader
+ * (режим BlockMode::Huffman — коды текущей таблицы, BlockMode::Stored — данные как есть).
+ * Кадр не пересекает точку перестроения; flush() закрывает кадр раньше, чтобы получатель
+ * мог декодировать все отправленное. Поток завершает кадр с исходным размером 0,
+ * в поле контрольной суммы которого записан CRC32C всего содержимого.
+ */
+
+/** @brief Магическое число адаптивного потока ("HUFS" в little-endian; "HUFA" занято контейнером). */
+constexpr uint32_t kAdaptiveMagic = 0x53465548;
+
+/** @brief Версия формата адаптивного потока. */
+constexpr uint8_t kAdaptiveVersion = 1;
+
+/** @brief Размер заголовка адаптивного потока в байтах. */
+constexpr size_t kAdaptiveHeaderSize = 9;
+
+/** @brief Интервал перестроения таблицы по умолчанию. */
+constexpr size_t kDefaultRebuildInterval = 16 * 1024;
+
+/** @brief Наименьший допустимый интервал перестроения. */
+constexpr size_t kMinRebuildInterval = 1024;
+
+/** @brief Наибольший допустимый интервал перестроения. */
+constexpr size_t kMaxRebuildInterval = 16 << 20;
+
+/**
+ * @brief Возвращает объем памяти кодировщика или декодера адаптивного потока.
+ * @param rebuild_interval Интервал перестроения.
+ * @return Оценка в байтах: буфер кадра, закодированный кадр и таблица кодов.
+ */
+inline uint64_t adaptiveMemoryBudget(size_t rebuild_interval) {
+    return rebuild_interval + frame::kBlockHeaderSize + CodeTable::encodedBound(rebuild_interval) + sizeof(CodeTable);
+}
+
+/**
+ * @class AdaptiveModel
+ * @brief Модель, общая для кодировщика и декодера: текущая таблица и накопленная гистограмма.
+ */
+class AdaptiveModel {
+private:
+    /** @brief Таблица кодов текущего интервала. */
+    std::unique_ptr<CodeTable> table;
+
+    /** @brief Гистограмма, по которой строится следующая таблица. */
+    uint64_t counts[256];
+
+    /** @brief Интервал перестроения. */
+    size_t interval;
+
+    /** @brief Байт, учтенных с последнего перестроения. */
+    size_t since_rebuild = 0;
+
+public:
+    /**
+     * @brief Создает модель с равными длинами кодов.
+     * @param interval Интервал перестроения.
+     * @throws std::runtime_error Если интервал вне [kMinRebuildInterval, kMaxRebuildInterval].
+     */
+    explicit AdaptiveModel(size_t interval);
+
+    /**
+     * @brief Возвращает интервал перестроения.
+     * @return Интервал в байтах.
+     */
+    size_t getInterval() const { return interval; }
+
+    /**
+     * @brief Возвращает текущую таблицу.
+     * @return Константная ссылка на таблицу.
+     */
+    const CodeTable& getTable() const { return *table; }
+
+    /**
+     * @brief Возвращает число байт до следующего перестроения.
+     * @return Размер, который может занять следующий кадр.
+     */
+    size_t remaining() const { return interval - since_rebuild; }
+
+    /**
+     * @brief Учитывает закодированные (или декодированные) данные и при необходимости перестраивает таблицу.
+     *
+     * При перестроении частота каждого символа равна накопленной плюс 1, чтобы любой байт
+     * имел код; затем гистограмма делится пополам, и старые данные постепенно забываются.
+     *
+     * @param data Данные кадра.
+     * @param size Размер данных, не больше remaining().
+     */
+    void update(const unsigned char* data, size_t size);
+};
+
+/**
+ * @class AdaptiveEncoder
+ * @brief Однопроходный кодировщик адаптивного потока.
+ *
+ * Данные копятся до точки перестроения или до flush(); память ограничена интервалом
+ * перестроения независимо от длины потока.
+ */
+class AdaptiveEncoder {
+private:
+    /** @brief Выходной поток. */
+    std::ostream& out;
+
+    /** @brief Модель кодирования. */
+    AdaptiveModel model;
+
+    /** @brief Данные текущего кадра. */
+    std::vector<unsigned char> pending;
+
+    /** @brief Буфер кадра: заголовок и полезная нагрузка. */
+    std::vector<unsigned char> encoded;
+
+    /** @brief CRC32C всего записанного содержимого. */
+    uint32_t content_checksum = 0;
+
+    /** @brief Вызван finish(). */
+    bool finished = false;
+
+    /** @brief Кодирует и записывает накопленный кадр. */
+    void emitFrame();
+
+public:
+    /**
+     * @brief Записывает заголовок потока.
+     * @param out Выходной поток.
+     * @param rebuild_interval Интервал перестроения таблицы.
+     * @throws std::runtime_error Если интервал недопустим или запись не удалась.
+     */
+    explicit AdaptiveEncoder(std::ostream& out, size_t rebuild_interval = kDefaultRebuildInterval);
+
+    /**
+     * @brief Сжимает очередную порцию данных.
+     * @param data Данные.
+     * @param size Размер данных.
+     * @throws std::runtime_error Если поток уже завершен или запись не удалась.
+     */
+    void write(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Записывает накопленные данные отдельным кадром и сбрасывает выходной поток.
+     *
+     * После flush() получатель может декодировать все записанное до этого момента.
+     * Частые вызовы добавляют по 13 байт заголовка кадра, но на модель не влияют.
+     *
+     * @throws std::runtime_error Если запись не удалась.
+     */
+    void flush();
+
+    /**
+     * @brief Записывает оставшиеся данные и признак конца потока.
+     * @throws std::runtime_error Если запись не удалась.
+     */
+    void finish();
+};
+
+/**
+ * @class AdaptiveDecoder
+ * @brief Декодер адаптивного потока, читающий кадры по мере необходимости.
+ */
+class AdaptiveDecoder {
+private:
+    /** @brief Входной поток. */
+    std::istream& in;
+
+    /** @brief Модель декодирования. */
+    AdaptiveModel model;
+
+    /** @brief Полезная нагрузка текущего кадра. */
+    std::vector<unsigned char> payload;
+
+    /** @brief Декодированные данные текущего кадра. */
+    std::vector<unsigned char> decoded;
+
+    /** @brief Позиция первого невыданного байта в decoded. */
+    size_t position = 0;
+
+    /** @brief CRC32C всего декодированного содержимого. */
+    uint32_t content_checksum = 0;
+
+    /** @brief Прочитан признак конца потока. */
+    bool finished = false;
+
+    /** @brief Читает и декодирует следующий кадр. */
+    void readFrame();
+
+public:
+    /**
+     * @brief Читает заголовок потока.
+     * @param in Входной поток.
+     * @throws std::runtime_error Если поток не является адаптивным или поврежден.
+     */
+    explicit AdaptiveDecoder(std::istream& in);
+
+    /**
+     * @brief Проверяет, начинается ли файл с заголовка адаптивного потока.
+     * @param path Путь к файлу.
+     * @return true, если файл является адаптивным потоком.
+     */
+    static bool isAdaptiveStream(const std::string& path);
+
+    /**
+     * @brief Возвращает интервал перестроения из заголовка потока.
+     * @return Интервал в байтах.
+     */
+    size_t getRebuildInterval() const { return model.getInterval(); }
+
+    /**
+     * @brief Читает распакованные данные.
+     *
+     * Если готовых данных нет, читает один кадр (блокируясь на входном потоке), поэтому
+     * данные, отправленные до flush(), выдаются без ожидания следующих.
+     *
+     * @param data Буфер.
+     * @param capacity Размер буфера.
+     * @return Число прочитанных байт; 0 — конец потока.
+     * @throws std::runtime_error Если поток поврежден или оборван.
+     */
+    size_t read(unsigned char* data, size_t capacity);
+};
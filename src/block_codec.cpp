@@ -0,0 +1,745 @@
+#include "block_codec.h"
+#include "dictionary.h"
+#include "checksum.h"
+#include "cpu_dispatch.h"
+#include "wide_table.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+frame::Header frame::makeHeader(const CompressOptions& options, uint64_t content_size) {
+    Header header;
+    header.block_size = static_cast<uint32_t>(options.block_size);
+    if (options.dictionary) {
+        header.flags |= kFlagDictionary;
+        header.dictionary_id = options.dictionary->getId();
+    }
+    if (options.seek_index) header.flags |= kFlagIndex;
+    if (options.optimal_lengths) header.flags |= kFlagOptimalLengths;
+    if (content_size) {
+        header.flags |= kFlagContentSize;
+        header.content_size = content_size;
+    }
+    return header;
+}
+
+void frame::writeHeader(const Header& header, unsigned char* out) {
+    putU32(out, kMagic);
+    out[4] = header.version;
+    out[5] = header.flags;
+    putU32(out + 6, header.block_size);
+    out += kHeaderSize;
+    if (header.flags & kFlagDictionary) {
+        putU32(out, header.dictionary_id);
+        out += 4;
+    }
+    if (header.flags & kFlagContentSize) putU64(out, header.content_size);
+}
+
+frame::Header frame::readHeader(const unsigned char* in) {
+    if (getU32(in) != kMagic) throw std::runtime_error("Unsupported archive format");
+    Header header;
+    header.version = in[4];
+    header.flags = in[5];
+    header.block_size = getU32(in + 6);
+    if (header.version != kVersion) throw std::runtime_error("Unsupported archive version");
+    if (header.block_size == 0 || header.block_size > kMaxBlockSize) throw std::runtime_error("Corrupted archive: invalid block size");
+    return header;
+}
+
+void frame::readHeaderExtension(Header& header, const unsigned char* in) {
+    if (header.flags & kFlagDictionary) {
+        header.dictionary_id = getU32(in);
+        in += 4;
+    }
+    if (header.flags & kFlagContentSize) header.content_size = getU64(in);
+}
+
+void frame::writeBlockHeader(const BlockHeader& header, unsigned char* out) {
+    putU32(out, header.raw_size);
+    out[4] = static_cast<unsigned char>(header.mode);
+    putU32(out + 5, header.payload_size);
+    putU32(out + 9, header.checksum);
+}
+
+frame::BlockHeader frame::readBlockHeader(const unsigned char* in) {
+    BlockHeader header;
+    header.raw_size = getU32(in);
+    if (in[4] > static_cast<unsigned char>(BlockMode::Wide)) {
+        throw std::runtime_error("Corrupted block: unknown block mode");
+    }
+    header.mode = static_cast<BlockMode>(in[4]);
+    header.payload_size = getU32(in + 5);
+    header.checksum = getU32(in + 9);
+    return header;
+}
+
+void frame::checkBlockHeader(const BlockHeader& block, const Header& header) {
+    if (block.raw_size > header.block_size) throw std::runtime_error("Corrupted block: block is larger than archive block size");
+    uint64_t limit = CodeTable::encodedBound(block.raw_size);
+    switch (block.mode) {
+    case BlockMode::Huffman: limit += 4 + 256 * 9; break;
+    case BlockMode::Stored: limit = block.raw_size; break;
+    case BlockMode::Rle: limit = 1; break;
+    case BlockMode::Wide: limit = 4 + 3 * uint64_t(kWideAlphabet) + 1 + WideCodeTable::encodedBound(block.raw_size); break;
+    default: break;
+    }
+    if (block.payload_size > limit) throw std::runtime_error("Corrupted block: payload is too large");
+    // Код Хаффмана занимает не меньше бита на символ, поэтому короткая нагрузка не может заявлять большой блок.
+    uint64_t min_bits = 0;
+    switch (block.mode) {
+    case BlockMode::Huffman:
+    case BlockMode::Dictionary:
+    case BlockMode::Repeat: min_bits = block.raw_size; break;
+    case BlockMode::Wide: min_bits = block.raw_size / 2; break;
+    default: break;
+    }
+    if (uint64_t(block.payload_size) * 8 < min_bits) throw std::runtime_error("Corrupted block: payload is too small");
+}
+
+void frame::writeIndexEntry(const IndexEntry& entry, unsigned char* out) {
+    putU64(out, entry.block_offset);
+    putU64(out + 8, entry.raw_offset);
+}
+
+frame::IndexEntry frame::readIndexEntry(const unsigned char* in) {
+    IndexEntry entry;
+    entry.block_offset = getU64(in);
+    entry.raw_offset = getU64(in + 8);
+    return entry;
+}
+
+void frame::writeIndexFooter(uint32_t count, unsigned char* out) {
+    putU32(out, count);
+    putU32(out + 4, kIndexMagic);
+}
+
+uint32_t frame::readIndexFooter(const unsigned char* in) {
+    if (getU32(in + 4) != kIndexMagic) throw std::runtime_error("Corrupted archive: missing block index");
+    return getU32(in);
+}
+
+namespace {
+
+#if defined(__GNUC__)
+#define HUFFMAN_KERNEL inline __attribute__((always_inline))
+#else
+#define HUFFMAN_KERNEL inline
+#endif
+
+void histogramKernel(const unsigned char* data, size_t size, uint64_t* counts) {
+    uint32_t partial[4][256] = {};
+    size_t i = 0;
+    while (i < size) {
+        size_t chunk_end = i + std::min<size_t>(size - i, UINT32_MAX);
+        for (; i + 4 <= chunk_end; i += 4) {
+            partial[0][data[i]]++;
+            partial[1][data[i + 1]]++;
+            partial[2][data[i + 2]]++;
+            partial[3][data[i + 3]]++;
+        }
+        for (; i < chunk_end; ++i) partial[0][data[i]]++;
+        for (int s = 0; s < 256; ++s) {
+            counts[s] += uint64_t(partial[0][s]) + partial[1][s] + partial[2][s] + partial[3][s];
+            partial[0][s] = partial[1][s] = partial[2][s] = partial[3][s] = 0;
+        }
+    }
+}
+
+HUFFMAN_KERNEL uint64_t loadBigEndian64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+HUFFMAN_KERNEL void storeBigEndian64(unsigned char* p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    std::memcpy(p, &v, sizeof(v));
+}
+
+size_t encodeKernel(const uint8_t* lengths, const uint16_t* codes, const unsigned char* data, size_t size, unsigned char* out) {
+    static_assert(7 + 4 * kMaxCodeLength <= 64, "four codes must fit into the bit accumulator");
+    // Накопленные биты выровнены по старшему разряду; после каждых четырех символов слово
+    // записывается целиком, а указатель сдвигается только на полные байты.
+    unsigned char* p = out;
+    uint64_t acc = 0;
+    unsigned bits = 0;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        for (unsigned k = 0; k < 4; ++k) {
+            bits += lengths[data[i + k]];
+            acc |= uint64_t(codes[data[i + k]]) << (64 - bits);
+        }
+        storeBigEndian64(p, acc);
+        p += bits >> 3;
+        acc <<= bits & ~7u;
+        bits &= 7;
+    }
+    for (; i < size; ++i) {
+        bits += lengths[data[i]];
+        acc |= uint64_t(codes[data[i]]) << (64 - bits);
+    }
+    storeBigEndian64(p, acc);
+    p += (bits + 7) >> 3;
+    return static_cast<size_t>(p - out);
+}
+
+
+
+// Медленный путь для записей kEscapeEntry: код длиннее индекса таблицы ищется по каноническим диапазонам длин.
+inline unsigned decodeLongCode(const CodeTable& table, unsigned table_bits, uint64_t word, unsigned char* out) {
+    for (unsigned len = table_bits + 1; len <= table.max_length; ++len) {
+        unsigned offset = static_cast<unsigned>(word >> (64 - len)) - table.first_code[len];
+        if (offset < unsigned(table.first_index[len + 1] - table.first_index[len])) {
+            *out = table.sorted_symbols[table.first_index[len] + offset];
+            return len;
+        }
+    }
+    throw std::runtime_error("Corrupted block: invalid code");
+}
+
+template <unsigned TableBits, bool Escapes>
+HUFFMAN_KERNEL unsigned decodeSymbol(const CodeTable& table, uint64_t word, unsigned char* out) {
+    uint16_t entry = table.decode_table[word >> (64 - TableBits)];
+    unsigned len = entry >> 8;
+    if (len == 0) {
+        if (Escapes && entry == kEscapeEntry) return decodeLongCode(table, TableBits, word, out);
+        throw std::runtime_error("Corrupted block: invalid code");
+    }
+    *out = static_cast<unsigned char>(entry);
+    return len;
+}
+
+template <unsigned TableBits, bool Escapes>
+HUFFMAN_KERNEL void decodeKernel(const CodeTable& table, const unsigned char* in, size_t size, unsigned char* out, size_t raw_size) {
+    // После чтения слова со сдвигом до 7 бит в нем не меньше 57 достоверных бит.
+    constexpr unsigned kSymbolsPerWord = 57 / (Escapes ? kMaxCodeLength : TableBits);
+    size_t bit_pos = 0;
+    size_t written = 0;
+    while (raw_size - written >= kSymbolsPerWord && (bit_pos >> 3) + 8 <= size) {
+        uint64_t word = loadBigEndian64(in + (bit_pos >> 3)) << (bit_pos & 7);
+        for (unsigned k = 0; k < kSymbolsPerWord; ++k) {
+            unsigned len = decodeSymbol<TableBits, Escapes>(table, word, out + written + k);
+            word <<= len;
+            bit_pos += len;
+        }
+        written += kSymbolsPerWord;
+    }
+    for (; written < raw_size; ++written) {
+        uint64_t word = 0;
+        for (size_t k = bit_pos >> 3; k < (bit_pos >> 3) + 8; ++k) word = (word << 8) | (k < size ? in[k] : 0);
+        word <<= bit_pos & 7;
+        bit_pos += decodeSymbol<TableBits, Escapes>(table, word, out + written);
+        // Быстрый цикл не выходит за входные данные, а здесь недостающие байты читаются как нули.
+        if (bit_pos > size * 8) throw std::runtime_error("Corrupted block: unexpected end of data");
+    }
+}
+
+using DecodeFunction = void (*)(const CodeTable&, const unsigned char*, size_t, unsigned char*, size_t);
+
+/** Табличные декодеры на 8, 10, 11 и 12 бит, затем 8-битная таблица с kEscapeEntry. */
+struct DecodeKernels {
+    DecodeFunction decode[5];
+};
+
+// Гистограмма и упаковка кодов собираются один раз: их варианты под target не давали выигрыша
+// больше шума измерений. Декодер встраивается в обертки с разными атрибутами target, и с BMI2
+// компилятор генерирует для переменных сдвигов shlx/shrx.
+#define HUFFMAN_DEFINE_DECODERS(name, attributes)                                                                              \
+    template <unsigned TableBits, bool Escapes>                                                                               \
+    attributes void name##Decode(const CodeTable& table, const unsigned char* in, size_t size, unsigned char* out, size_t raw) { \
+        decodeKernel<TableBits, Escapes>(table, in, size, out, raw);                                                          \
+    }                                                                                                                         \
+    const DecodeKernels name##Decoders = {{name##Decode<8, false>, name##Decode<10, false>, name##Decode<11, false>,          \
+                                           name##Decode<12, false>, name##Decode<8, true>}};
+
+HUFFMAN_DEFINE_DECODERS(generic, )
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HUFFMAN_HAVE_X86_KERNELS 1
+HUFFMAN_DEFINE_DECODERS(avx2, __attribute__((target("sse4.2,popcnt,avx2,bmi,bmi2,lzcnt"))))
+#endif
+
+#undef HUFFMAN_DEFINE_DECODERS
+
+const DecodeKernels& decoders() {
+#ifdef HUFFMAN_HAVE_X86_KERNELS
+    if (activeKernelSet() == KernelSet::Avx2) return avx2Decoders;
+#endif
+    return genericDecoders;
+}
+
+}
+
+void countHistogram(const unsigned char* data, size_t size, uint64_t* counts) {
+    histogramKernel(data, size, counts);
+}
+
+namespace {
+
+void packageMerge(const Node* leaves, unsigned n, unsigned* length_count) {
+    int16_t items[kMaxCodeLength][512];
+    unsigned sizes[kMaxCodeLength];
+    uint64_t weights[2][512];
+
+    unsigned cur = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        weights[cur][i] = leaves[i].freq;
+        items[kMaxCodeLength - 1][i] = static_cast<int16_t>(i);
+    }
+    sizes[kMaxCodeLength - 1] = n;
+    for (int level = kMaxCodeLength - 2; level >= 0; --level) {
+        unsigned prev = cur;
+        cur ^= 1;
+        unsigned packages = sizes[level + 1] / 2;
+        unsigned i = 0, j = 0, k = 0;
+        while (i < n || j < packages) {
+            uint64_t package = j < packages ? weights[prev][2 * j] + weights[prev][2 * j + 1] : UINT64_MAX;
+            if (i < n && leaves[i].freq <= package) {
+                weights[cur][k] = leaves[i].freq;
+                items[level][k++] = static_cast<int16_t>(i++);
+            } else {
+                weights[cur][k] = package;
+                items[level][k++] = -1;
+                j++;
+            }
+        }
+        sizes[level] = k;
+    }
+
+    // Выбранные элементы каждого уровня образуют префикс списка; пакет раскрывается в два элемента следующего уровня.
+    uint8_t lengths[256] = {};
+    unsigned take = 2 * n - 2;
+    for (unsigned level = 0; level < kMaxCodeLength && take > 0; ++level) {
+        unsigned packages = 0;
+        for (unsigned k = 0; k < take; ++k) {
+            if (items[level][k] >= 0) {
+                lengths[items[level][k]]++;
+            } else {
+                packages++;
+            }
+        }
+        take = 2 * packages;
+    }
+    for (unsigned len = 0; len <= kMaxCodeLength; ++len) length_count[len] = 0;
+    for (unsigned i = 0; i < n; ++i) length_count[lengths[i]]++;
+}
+
+}
+
+CodeTable::CodeTable() {
+    std::memset(freq, 0, sizeof(freq));
+    std::memset(lengths, 0, sizeof(lengths));
+    std::memset(codes, 0, sizeof(codes));
+}
+
+unsigned buildCodeLengths(const uint64_t* freq, unsigned alphabet, unsigned limit, bool optimal, Node* nodes, uint8_t* lengths) {
+    unsigned n = 0;
+    for (unsigned s = 0; s < alphabet; ++s) {
+        if (freq[s]) nodes[n++] = Node{static_cast<uint16_t>(s), freq[s], 0};
+    }
+    std::memset(lengths, 0, alphabet);
+    if (n == 0) return 0;
+
+    std::sort(nodes, nodes + n, [](const Node& a, const Node& b) {
+        return a.freq != b.freq ? a.freq < b.freq : a.symbol < b.symbol;
+    });
+
+    // Сумма частот помещается в uint64_t, поэтому глубина дерева меньше 256.
+    unsigned length_count[256] = {};
+    if (n == 1) {
+        length_count[1] = 1;
+    } else {
+        unsigned leaf = 0, internal = n, total = n;
+        auto takeSmallest = [&]() -> unsigned {
+            if (internal < total && (leaf >= n || nodes[internal].freq < nodes[leaf].freq)) return internal++;
+            return leaf++;
+        };
+        while (total < 2 * n - 1) {
+            unsigned a = takeSmallest();
+            unsigned b = takeSmallest();
+            nodes[a].parent = nodes[b].parent = total;
+            nodes[total++] = Node{0, nodes[a].freq + nodes[b].freq, 0};
+        }
+
+        // Родитель стоит правее потомка, поэтому глубины можно записать на место ссылок на родителей.
+        nodes[total - 1].parent = 0;
+        for (unsigned i = total - 1; i-- > 0;) {
+            nodes[i].parent = nodes[nodes[i].parent].parent + 1;
+            if (i < n) length_count[nodes[i].parent]++;
+        }
+
+        unsigned longest = 0;
+        for (unsigned len = 1; len < 256; ++len) {
+            if (length_count[len]) longest = len;
+        }
+        if (longest > limit && optimal && alphabet <= 256 && limit == kMaxCodeLength) {
+            for (unsigned len = kMaxCodeLength + 1; len <= longest; ++len) length_count[len] = 0;
+            packageMerge(nodes, n, length_count);
+        } else if (longest > limit) {
+            for (unsigned len = limit + 1; len <= longest; ++len) {
+                length_count[limit] += length_count[len];
+                length_count[len] = 0;
+            }
+            uint64_t kraft = 0;
+            for (unsigned len = 1; len <= limit; ++len) {
+                kraft += uint64_t(length_count[len]) << (limit - len);
+            }
+            while (kraft > (uint64_t(1) << limit)) {
+                length_count[limit]--;
+                for (unsigned len = limit - 1; len > 0; --len) {
+                    if (length_count[len]) {
+                        length_count[len]--;
+                        length_count[len + 1] += 2;
+                        break;
+                    }
+                }
+                kraft--;
+            }
+        }
+    }
+
+    // Короткие коды достаются самым частым символам: листья отсортированы по возрастанию частоты.
+    unsigned leaf = n;
+    unsigned max_length = 0;
+    for (unsigned len = 1; len <= limit; ++len) {
+        for (unsigned k = 0; k < length_count[len]; ++k) {
+            lengths[nodes[--leaf].symbol] = static_cast<uint8_t>(len);
+        }
+        if (length_count[len]) max_length = len;
+    }
+    return max_length;
+}
+
+void CodeTable::buildLengths() {
+    Node nodes[511];
+    symbol_count = 0;
+    for (int s = 0; s < 256; ++s) symbol_count += freq[s] != 0;
+    max_length = buildCodeLengths(freq, 256, kMaxCodeLength, optimal_lengths, nodes, lengths);
+}
+
+void CodeTable::buildCodes() {
+    unsigned length_count[kMaxCodeLength + 1] = {};
+    for (int s = 0; s < 256; ++s) length_count[lengths[s]]++;
+    length_count[0] = 0;
+
+    uint32_t kraft = 0;
+    for (unsigned len = 1; len <= kMaxCodeLength; ++len) kraft += length_count[len] << (kMaxCodeLength - len);
+    if (kraft > (1u << kMaxCodeLength)) {
+        throw std::runtime_error("Corrupted frequency table: invalid code lengths");
+    }
+
+    uint16_t next_code[kMaxCodeLength + 1] = {};
+    uint16_t next_index[kMaxCodeLength + 1] = {};
+    uint16_t code = 0;
+    first_index[0] = first_index[1] = 0;
+    for (unsigned len = 1; len <= kMaxCodeLength; ++len) {
+        code = static_cast<uint16_t>((code + length_count[len - 1]) << 1);
+        first_code[len] = next_code[len] = code;
+        first_index[len + 1] = static_cast<uint16_t>(first_index[len] + length_count[len]);
+        next_index[len] = first_index[len];
+    }
+    for (int s = 0; s < 256; ++s) {
+        unsigned len = lengths[s];
+        if (!len) continue;
+        codes[s] = next_code[len]++;
+        sorted_symbols[next_index[len]++] = static_cast<uint8_t>(s);
+    }
+}
+
+void CodeTable::buildDecodeTable() {
+    unsigned full_bits = max_length <= 8 ? 8 : max_length <= 10 ? 10 : max_length;
+    uint64_t total = 0;
+    for (int s = 0; s < 256; ++s) total += freq[s];
+    // Пока символов меньше четырех на запись полной таблицы, ее заполнение не окупается:
+    // 8-битная таблица с дочитыванием длинных кодов заметно дешевле строится и помещается в L1.
+    table_bits = total < (uint64_t(4) << full_bits) ? 8 : full_bits;
+
+    // Канонические коды одной длины идут подряд и по возрастанию длины, поэтому их диапазоны в таблице смежны.
+    unsigned table_size = 1u << table_bits;
+    unsigned pos = 0;
+    unsigned end = first_index[std::min(table_bits, max_length) + 1];
+    for (unsigned i = 0; i < end; ++i) {
+        unsigned symbol = sorted_symbols[i];
+        unsigned len = lengths[symbol];
+        uint16_t entry = static_cast<uint16_t>(symbol | (len << 8));
+        unsigned count = 1u << (table_bits - len);
+        std::fill(decode_table + pos, decode_table + pos + count, entry);
+        pos += count;
+    }
+    std::fill(decode_table + pos, decode_table + table_size, table_bits < max_length ? kEscapeEntry : uint16_t(0));
+}
+
+void CodeTable::build() {
+    buildLengths();
+    if (symbol_count == 0) return;
+    buildCodes();
+    buildDecodeTable();
+}
+
+uint64_t CodeTable::encodedBits() const {
+    uint64_t bits = 0;
+    for (int s = 0; s < 256; ++s) bits += freq[s] * lengths[s];
+    return bits;
+}
+
+size_t CodeTable::writeFrequencyTable(unsigned char* out) const {
+    frame::putU32(out, symbol_count);
+    size_t pos = 4;
+    for (int s = 0; s < 256; ++s) {
+        if (!freq[s]) continue;
+        out[pos] = static_cast<unsigned char>(s);
+        frame::putU64(out + pos + 1, freq[s]);
+        pos += 9;
+    }
+    return pos;
+}
+
+size_t CodeTable::readFrequencyTable(const unsigned char* in, size_t size) {
+    std::memset(freq, 0, sizeof(freq));
+    if (size < 4) throw std::runtime_error("Failed to read frequency table size");
+    uint32_t count = frame::getU32(in);
+    if (count == 0 || count > 256) throw std::runtime_error("Corrupted frequency table: invalid symbol count");
+    size_t pos = 4;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (size - pos < 1) throw std::runtime_error("Corrupted frequency table: failed to read symbol");
+        if (size - pos < 9) throw std::runtime_error("Corrupted frequency table: failed to read frequency");
+        uint64_t value = frame::getU64(in + pos + 1);
+        if (freq[in[pos]]) throw std::runtime_error("Corrupted frequency table: duplicate symbol");
+        if (value == 0) throw std::runtime_error("Corrupted frequency table: zero frequency");
+        if (value > UINT64_MAX - total) throw std::runtime_error("Corrupted frequency table: frequency overflow");
+        freq[in[pos]] = value;
+        total += value;
+        pos += 9;
+    }
+    return pos;
+}
+
+size_t CodeTable::encodeBits(const unsigned char* data, size_t size, unsigned char* out) const {
+    return encodeKernel(lengths, codes, data, size, out);
+}
+
+void CodeTable::decodeBits(const unsigned char* in, size_t size, unsigned char* out, size_t raw_size) const {
+    if (symbol_count == 0) throw std::runtime_error("Archive is empty or corrupted");
+    const DecodeKernels& set = decoders();
+    if (table_bits < max_length) {
+        set.decode[4](*this, in, size, out, raw_size);
+        return;
+    }
+    switch (table_bits) {
+    case 8: set.decode[0](*this, in, size, out, raw_size); break;
+    case 10: set.decode[1](*this, in, size, out, raw_size); break;
+    case 11: set.decode[2](*this, in, size, out, raw_size); break;
+    default: set.decode[3](*this, in, size, out, raw_size); break;
+    }
+}
+
+std::map<unsigned char, std::string> CodeTable::toCodeMap() const {
+    std::map<unsigned char, std::string> result;
+    for (int s = 0; s < 256; ++s) {
+        if (!lengths[s]) continue;
+        std::string code;
+        for (int bit = lengths[s] - 1; bit >= 0; --bit) {
+            code += ((codes[s] >> bit) & 1) ? '1' : '0';
+        }
+        result[static_cast<unsigned char>(s)] = code;
+    }
+    return result;
+}
+
+namespace {
+
+bool isIncompressible(const uint64_t* counts, uint64_t size) {
+    unsigned symbols = 0;
+    double entropy = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (!counts[s]) continue;
+        symbols++;
+        entropy += counts[s] * std::log2(static_cast<double>(size) / counts[s]);
+    }
+    return symbols > 1 && entropy + (4 + 9 * symbols) * 8 >= size * 8;
+}
+
+}
+
+BlockCodec::BlockCodec() = default;
+
+BlockCodec::~BlockCodec() = default;
+
+uint64_t BlockCodec::wideCost(const unsigned char* data, size_t size) {
+    if (!wide) wide = std::make_unique<WideCodeTable>();
+    std::fill(wide->freq.begin(), wide->freq.end(), 0);
+    countWideHistogram(data, size, wide->freq.data());
+    wide->buildLengths();
+    return wide->lengthTableSize() + (size & 1) + (wide->encodedBits() + 7) / 8;
+}
+
+uint64_t BlockCodec::estimateCost(const uint64_t* counts) {
+    std::memcpy(planner.freq, counts, sizeof(planner.freq));
+    planner.buildLengths();
+    return planner.frequencyTableSize() * 8 + planner.encodedBits();
+}
+
+size_t BlockCodec::encode(const unsigned char* data, size_t size, unsigned char* out, const Dictionary* dictionary, size_t split_segment) {
+    if (dictionary) {
+        frame::BlockHeader header;
+        header.raw_size = static_cast<uint32_t>(size);
+        header.mode = frame::BlockMode::Dictionary;
+        header.checksum = crc32c(0, data, size);
+        header.payload_size = static_cast<uint32_t>(dictionary->getTable().encodeBits(data, size, out + frame::kBlockHeaderSize));
+        frame::writeBlockHeader(header, out);
+        return frame::kBlockHeaderSize + header.payload_size;
+    }
+
+    uint64_t counts[256] = {};
+    size_t segment_size = split_segment ? std::max(split_segment, kMinSplitSegmentSize) : size;
+    countHistogram(data, std::min(size, segment_size), counts);
+    if (size <= segment_size) return encodeBlock(data, size, counts, out);
+
+    // Несжимаемые сегменты подряд объединяются без построения длин: блок все равно будет записан как есть.
+    size_t pos = 0;
+    size_t start = 0;
+    bool block_stored = isIncompressible(counts, segment_size);
+    uint64_t block_cost = block_stored ? UINT64_MAX : estimateCost(counts);
+    for (size_t offset = segment_size; offset < size; offset += segment_size) {
+        size_t length = std::min(segment_size, size - offset);
+        uint64_t segment[256] = {};
+        countHistogram(data + offset, length, segment);
+        uint64_t merged[256];
+        for (int s = 0; s < 256; ++s) merged[s] = counts[s] + segment[s];
+
+        bool segment_stored = isIncompressible(segment, length);
+        if (block_stored && segment_stored) {
+            std::memcpy(counts, merged, sizeof(merged));
+            block_cost = UINT64_MAX;
+            continue;
+        }
+        if (block_cost == UINT64_MAX) block_cost = estimateCost(counts);
+        uint64_t segment_cost = estimateCost(segment);
+        uint64_t merged_cost = estimateCost(merged);
+        if (merged_cost <= block_cost + segment_cost) {
+            std::memcpy(counts, merged, sizeof(merged));
+            block_cost = merged_cost;
+            block_stored = isIncompressible(counts, offset + length - start);
+        } else {
+            pos += encodeBlock(data + start, offset - start, counts, out + pos);
+            std::memcpy(counts, segment, sizeof(segment));
+            block_cost = segment_cost;
+            block_stored = segment_stored;
+            start = offset;
+        }
+    }
+    return pos + encodeBlock(data + start, size - start, counts, out + pos);
+}
+
+uint64_t BlockCodec::reuseCost(const uint64_t* counts) const {
+    if (!has_table) return UINT64_MAX;
+    uint64_t bits = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (!counts[s]) continue;
+        if (!table.lengths[s]) return UINT64_MAX;
+        bits += counts[s] * table.lengths[s];
+    }
+    return bits;
+}
+
+size_t BlockCodec::encodeBlock(const unsigned char* data, size_t size, const uint64_t* counts, unsigned char* out) {
+    unsigned char* payload = out + frame::kBlockHeaderSize;
+    size_t payload_size = 0;
+
+    frame::BlockHeader header;
+    header.raw_size = static_cast<uint32_t>(size);
+    header.checksum = crc32c(0, data, size);
+
+    uint64_t reuse_cost = reuseCost(counts);
+    uint64_t wide_size = wide_symbols && size >= 2 && counts[data[0]] != size ? wideCost(data, size) : UINT64_MAX;
+    if (counts[data[0]] == size) {
+        header.mode = frame::BlockMode::Rle;
+        payload[0] = data[0];
+        payload_size = 1;
+    } else if (wide_size < size && wide_size * 8 < std::min(reuse_cost, estimateCost(counts))) {
+        header.mode = frame::BlockMode::Wide;
+        wide->buildCodes();
+        payload_size = wide->writeLengthTable(payload);
+        if (size & 1) payload[payload_size++] = data[size - 1];
+        payload_size += wide->encodeSymbols(data, size, payload + payload_size);
+    } else if (isIncompressible(counts, size) && reuse_cost >= uint64_t(size) * 8) {
+        header.mode = frame::BlockMode::Stored;
+    } else {
+        if (reuse_cost <= estimateCost(counts)) {
+            header.mode = frame::BlockMode::Repeat;
+        } else {
+            std::memcpy(table.freq, counts, sizeof(table.freq));
+            table.buildLengths();
+            table.buildCodes();
+            has_table = true;
+            payload_size = table.writeFrequencyTable(payload);
+        }
+        payload_size += table.encodeBits(data, size, payload + payload_size);
+        if (payload_size >= size) {
+            // Декодер такую таблицу не увидит, поэтому следующие блоки не должны на нее ссылаться.
+            if (header.mode == frame::BlockMode::Huffman) has_table = false;
+            header.mode = frame::BlockMode::Stored;
+        }
+    }
+    if (header.mode == frame::BlockMode::Stored) {
+        std::memcpy(payload, data, size);
+        payload_size = size;
+    }
+
+    header.payload_size = static_cast<uint32_t>(payload_size);
+    frame::writeBlockHeader(header, out);
+    return frame::kBlockHeaderSize + payload_size;
+}
+
+void BlockCodec::encode(const unsigned char* data, size_t size, std::vector<unsigned char>& out, const Dictionary* dictionary, size_t split_segment) {
+    size_t pos = out.size();
+    out.resize(pos + encodeBound(size));
+    out.resize(pos + encode(data, size, out.data() + pos, dictionary, split_segment));
+}
+
+size_t BlockCodec::loadTable(const unsigned char* payload, size_t size) {
+    has_table = false;
+    size_t used = table.readFrequencyTable(payload, size);
+    table.build();
+    if (table.symbol_count == 0) throw std::runtime_error("Archive is empty or corrupted");
+    has_table = true;
+    return used;
+}
+
+void BlockCodec::decode(const frame::BlockHeader& header, const unsigned char* payload, unsigned char* out, const Dictionary* dictionary) {
+    if (header.mode == frame::BlockMode::Dictionary) {
+        if (!dictionary) throw std::runtime_error("Corrupted block: dictionary block without dictionary");
+        dictionary->getTable().decodeBits(payload, header.payload_size, out, header.raw_size);
+    } else if (header.mode == frame::BlockMode::Repeat) {
+        if (!has_table) throw std::runtime_error("Corrupted block: no table to reuse");
+        table.decodeBits(payload, header.payload_size, out, header.raw_size);
+    } else if (header.mode == frame::BlockMode::Stored) {
+        if (header.payload_size != header.raw_size) throw std::runtime_error("Corrupted block: stored size mismatch");
+        std::memcpy(out, payload, header.raw_size);
+    } else if (header.mode == frame::BlockMode::Rle) {
+        if (header.payload_size != 1) throw std::runtime_error("Corrupted block: invalid run");
+        std::memset(out, payload[0], header.raw_size);
+    } else if (header.mode == frame::BlockMode::Wide) {
+        if (!wide) wide = std::make_unique<WideCodeTable>();
+        size_t pos = wide->readLengthTable(payload, header.payload_size);
+        if (header.raw_size & 1) {
+            if (pos >= header.payload_size) throw std::runtime_error("Corrupted block: unexpected end of data");
+            out[header.raw_size - 1] = payload[pos++];
+        }
+        wide->decodeSymbols(payload + pos, header.payload_size - pos, out, header.raw_size);
+    } else {
+        size_t pos = loadTable(payload, header.payload_size);
+        uint64_t total = 0;
+        for (int s = 0; s < 256; ++s) total += table.freq[s];
+        if (total != header.raw_size) throw std::runtime_error("Corrupted block: frequency table does not match block size");
+        table.decodeBits(payload + pos, header.payload_size - pos, out, header.raw_size);
+    }
+    if (crc32c(0, out, header.raw_size) != header.checksum) throw std::runtime_error("Corrupted block: checksum mismatch");
+}
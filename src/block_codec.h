@@ -0,0 +1,661 @@
+#pragma once
+#include "huffman.h"
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file block_codec.h
+ * @brief Блочный формат архива .huff и кодек отдельного блока.
+ *
+ * Архив состоит из заголовка и последовательности независимых блоков, каждый
+ * из которых несет собственную таблицу частот. Независимость блоков позволяет
+ * кодировать их параллельно и записывать по мере готовности.
+ *
+ * Раскладка (все числа little-endian):
+ * - заголовок: магическое число "HUFB", версия (1 байт), флаги (1 байт),
+ *   номинальный размер блока (uint32), при флаге kFlagDictionary — идентификатор
+ *   словаря (uint32), при флаге kFlagContentSize — исходный размер содержимого (uint64);
+ * - блок: исходный размер (uint32), режим (1 байт), размер полезной нагрузки (uint32),
+ *   CRC32C исходных данных блока (uint32), полезная нагрузка;
+ * - признак конца: заголовок блока с исходным размером 0, в поле контрольной суммы
+ *   которого записан CRC32C всего исходного содержимого;
+ * - при флаге kFlagIndex — индекс блоков: для каждого блока смещение его заголовка
+ *   от начала архива (uint64) и смещение его данных в исходном содержимом (uint64),
+ *   затем число блоков (uint32) и магическое число "HUFX". Индекс читается с конца
+ *   архива и позволяет распаковать диапазон, не декодируя предшествующие блоки.
+ */
+namespace frame {
+
+/** @brief Магическое число архива ("HUFB" в little-endian). */
+constexpr uint32_t kMagic = 0x42465548;
+
+/** @brief Текущая версия формата. */
+constexpr uint8_t kVersion = 3;
+
+/** @brief Размер обязательной части заголовка архива в байтах. */
+constexpr size_t kHeaderSize = 10;
+
+/** @brief Наибольший размер заголовка архива со всеми необязательными полями. */
+constexpr size_t kMaxHeaderSize = kHeaderSize + 4 + 8;
+
+/**
+ * @brief Наибольший размер блока архива.
+ *
+ * Поле block_size заголовка задает предел размера буферов декодера, поэтому
+ * архив с большим значением отклоняется до чтения блоков, а кодер не создает
+ * такие архивы.
+ */
+constexpr uint32_t kMaxBlockSize = 64u << 20;
+
+/** @brief Размер заголовка блока в байтах. */
+constexpr size_t kBlockHeaderSize = 13;
+
+/** @brief Способ кодирования полезной нагрузки блока. */
+enum class BlockMode : uint8_t {
+    /** @brief Таблица частот и поток кодов Хаффмана. */
+    Huffman = 0,
+
+    /** @brief Поток кодов Хаффмана по таблице словаря архива. */
+    Dictionary = 1,
+
+    /** @brief Поток кодов Хаффмана по таблице предыдущего блока с собственной таблицей. */
+    Repeat = 2,
+
+    /** @brief Исходные данные без сжатия (несжимаемый блок). */
+    Stored = 3,
+
+    /** @brief Один байт, повторенный raw_size раз (блок из одного символа). */
+    Rle = 4,
+
+    /** @brief Таблица длин и поток кодов 16-битных символов (см. wide_table.h). */
+    Wide = 5,
+};
+
+/** @brief Флаг заголовка: за заголовком следует идентификатор словаря (uint32). */
+constexpr uint8_t kFlagDictionary = 0x01;
+
+/** @brief Флаг заголовка: за признаком конца следует индекс блоков. */
+constexpr uint8_t kFlagIndex = 0x02;
+
+/** @brief Флаг заголовка: длины кодов строятся алгоритмом package-merge (CodeTable::optimal_lengths). */
+constexpr uint8_t kFlagOptimalLengths = 0x04;
+
+/** @brief Флаг заголовка: в заголовке записан исходный размер содержимого (uint64). */
+constexpr uint8_t kFlagContentSize = 0x08;
+
+/**
+ * @brief Флаг заголовка: архив из одного блока без признака конца и индекса.
+ *
+ * Исходный размер и CRC32C содержимого совпадают с raw_size и checksum этого
+ * блока, поэтому kFlagContentSize при нем не ставится. Так сжатие в памяти
+ * экономит 21 байт на каждом коротком сообщении.
+ */
+constexpr uint8_t kFlagSingleBlock = 0x10;
+
+/** @brief Магическое число в конце индекса блоков ("HUFX" в little-endian). */
+constexpr uint32_t kIndexMagic = 0x58465548;
+
+/** @brief Размер записи индекса блоков в байтах. */
+constexpr size_t kIndexEntrySize = 16;
+
+/** @brief Размер хвоста индекса (число блоков и магическое число) в байтах. */
+constexpr size_t kIndexFooterSize = 8;
+
+/** @brief Заголовок архива. */
+struct Header {
+    /** @brief Версия формата. */
+    uint8_t version = kVersion;
+
+    /** @brief Флаги архива (kFlag*). */
+    uint8_t flags = 0;
+
+    /** @brief Номинальный размер блока, с которым архив был создан. */
+    uint32_t block_size = 0;
+
+    /** @brief Идентификатор словаря (при флаге kFlagDictionary). */
+    uint32_t dictionary_id = 0;
+
+    /** @brief Исходный размер содержимого (при флаге kFlagContentSize). */
+    uint64_t content_size = 0;
+};
+
+/**
+ * @brief Возвращает полный размер заголовка с необязательными полями.
+ * @param flags Флаги заголовка.
+ * @return Размер заголовка в байтах.
+ */
+inline size_t headerSize(uint8_t flags) {
+    return kHeaderSize + ((flags & kFlagDictionary) ? 4 : 0) + ((flags & kFlagContentSize) ? 8 : 0);
+}
+
+/**
+ * @brief Проверяет, закончился ли архив после последнего прочитанного блока без признака конца.
+ * @param header Заголовок архива.
+ * @param blocks Число уже прочитанных блоков.
+ * @return true для архива с kFlagSingleBlock после его единственного блока.
+ */
+inline bool implicitEnd(const Header& header, uint64_t blocks) {
+    return (header.flags & kFlagSingleBlock) && blocks == 1;
+}
+
+/** @brief Заголовок блока. */
+struct BlockHeader {
+    /** @brief Размер исходных данных блока (0 — конец архива). */
+    uint32_t raw_size = 0;
+
+    /** @brief Режим кодирования блока. */
+    BlockMode mode = BlockMode::Huffman;
+
+    /** @brief Размер полезной нагрузки в байтах. */
+    uint32_t payload_size = 0;
+
+    /** @brief CRC32C исходных данных блока; в признаке конца — CRC32C всего содержимого. */
+    uint32_t checksum = 0;
+};
+
+/** @brief Запись индекса блоков. */
+struct IndexEntry {
+    /** @brief Смещение заголовка блока от начала архива. */
+    uint64_t block_offset = 0;
+
+    /** @brief Смещение первого байта блока в исходном содержимом. */
+    uint64_t raw_offset = 0;
+};
+
+/**
+ * @brief Возвращает размер индекса из count блоков вместе с хвостом.
+ * @param count Число блоков.
+ * @return Размер в байтах.
+ */
+inline size_t indexSize(size_t count) { return count * kIndexEntrySize + kIndexFooterSize; }
+
+inline void putU32(unsigned char* p, uint32_t v) { std::memcpy(p, &v, sizeof(v)); }
+inline void putU64(unsigned char* p, uint64_t v) { std::memcpy(p, &v, sizeof(v)); }
+inline uint32_t getU32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+inline uint64_t getU64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+/**
+ * @brief Формирует заголовок архива для заданных параметров сжатия.
+ * @param options Параметры сжатия.
+ * @param content_size Исходный размер содержимого (0 — неизвестен, поле не пишется).
+ * @return Заголовок архива.
+ */
+Header makeHeader(const CompressOptions& options, uint64_t content_size = 0);
+
+/**
+ * @brief Сериализует заголовок архива.
+ * @param header Заголовок.
+ * @param out Буфер размером не менее headerSize(header.flags) байт.
+ */
+void writeHeader(const Header& header, unsigned char* out);
+
+/**
+ * @brief Разбирает обязательную часть заголовка архива.
+ *
+ * Необязательные поля (см. headerSize()) разбираются readHeaderExtension().
+ *
+ * @param in Буфер размером не менее kHeaderSize байт.
+ * @return Разобранный заголовок.
+ * @throws std::runtime_error Если магическое число или версия не совпадают.
+ */
+Header readHeader(const unsigned char* in);
+
+/**
+ * @brief Разбирает необязательные поля заголовка, следующие за обязательной частью.
+ * @param header Заголовок, прочитанный readHeader().
+ * @param in Буфер размером не менее headerSize(header.flags) - kHeaderSize байт.
+ */
+void readHeaderExtension(Header& header, const unsigned char* in);
+
+/**
+ * @brief Сериализует заголовок блока.
+ * @param header Заголовок блока.
+ * @param out Буфер размером не менее kBlockHeaderSize байт.
+ */
+void writeBlockHeader(const BlockHeader& header, unsigned char* out);
+
+/**
+ * @brief Разбирает заголовок блока.
+ * @param in Буфер размером не менее kBlockHeaderSize байт.
+ * @return Разобранный заголовок блока.
+ * @throws std::runtime_error Если режим блока неизвестен.
+ */
+BlockHeader readBlockHeader(const unsigned char* in);
+
+/**
+ * @brief Проверяет размеры блока до выделения памяти под него.
+ *
+ * Исходный размер не может превышать размер блока архива, а полезная нагрузка —
+ * наибольший размер, который кодировщик способен записать в данном режиме. Для
+ * блоков с кодами Хаффмана нагрузка должна содержать хотя бы бит на символ.
+ * Так объем памяти и время разбора блока ограничены еще до чтения его данных.
+ *
+ * @param block Заголовок блока (не признак конца).
+ * @param header Заголовок архива.
+ * @throws std::runtime_error Если размеры блока недопустимы.
+ */
+void checkBlockHeader(const BlockHeader& block, const Header& header);
+
+/**
+ * @brief Сериализует запись индекса блоков.
+ * @param entry Запись индекса.
+ * @param out Буфер размером не менее kIndexEntrySize байт.
+ */
+void writeIndexEntry(const IndexEntry& entry, unsigned char* out);
+
+/**
+ * @brief Разбирает запись индекса блоков.
+ * @param in Буфер размером не менее kIndexEntrySize байт.
+ * @return Запись индекса.
+ */
+IndexEntry readIndexEntry(const unsigned char* in);
+
+/**
+ * @brief Сериализует хвост индекса блоков.
+ * @param count Число блоков.
+ * @param out Буфер размером не менее kIndexFooterSize байт.
+ */
+void writeIndexFooter(uint32_t count, unsigned char* out);
+
+/**
+ * @brief Разбирает хвост индекса блоков.
+ * @param in Буфер размером не менее kIndexFooterSize байт.
+ * @return Число блоков в индексе.
+ * @throws std::runtime_error Если магическое число не совпадает.
+ */
+uint32_t readIndexFooter(const unsigned char* in);
+
+} // namespace frame
+
+/** @brief Максимальная длина кода Хаффмана в битах. */
+constexpr unsigned kMaxCodeLength = 12;
+
+/** @brief Запись таблицы декодирования, отсылающая к коду длиннее ее индекса (длина 0, символ 1). */
+constexpr uint16_t kEscapeEntry = 0x0001;
+
+/** @brief Наименьший размер сегмента, по которому адаптивное разбиение ищет границы блоков. */
+constexpr size_t kMinSplitSegmentSize = 4 * 1024;
+
+/**
+ * @brief Считает гистограмму байтов.
+ *
+ * Использует четыре независимые таблицы счетчиков, чтобы соседние одинаковые
+ * байты не упирались в зависимость по памяти при инкременте.
+ *
+ * @param data Данные.
+ * @param size Размер данных.
+ * @param counts Массив из 256 счетчиков; к нему прибавляются частоты.
+ */
+void countHistogram(const unsigned char* data, size_t size, uint64_t* counts);
+
+/**
+ * @brief Строит длины канонических кодов Хаффмана с ограничением длины для алфавита произвольного размера.
+ *
+ * Длины, превысившие limit, укорачиваются эвристикой с восстановлением неравенства
+ * Крафта; при optimal (только для алфавита до 256 символов и limit == kMaxCodeLength)
+ * вместо эвристики используется package-merge.
+ *
+ * @param freq Частоты символов (0 — символ отсутствует).
+ * @param alphabet Размер алфавита (не больше 65536).
+ * @param limit Максимальная длина кода; 2^limit не меньше числа символов.
+ * @param optimal Ограничивать длины оптимально.
+ * @param nodes Рабочий массив не менее чем из 2 * alphabet - 1 узлов.
+ * @param lengths Выход: alphabet длин кодов (0 — символ отсутствует).
+ * @return Максимальная длина кода (0, если все частоты нулевые).
+ */
+unsigned buildCodeLengths(const uint64_t* freq, unsigned alphabet, unsigned limit, bool optimal, Node* nodes, uint8_t* lengths);
+
+/**
+ * @struct CodeTable
+ * @brief Таблица частот с каноническими кодами Хаффмана и таблицей декодирования.
+ *
+ * Все данные хранятся в массивах фиксированного размера, поэтому построение
+ * таблицы не выделяет память. Длины кодов ограничены kMaxCodeLength; коды
+ * канонические и записываются начиная со старшего бита, так что каждый код
+ * занимает непрерывный диапазон таблицы декодирования.
+ *
+ * После build() таблица используется только для чтения, поэтому одну таблицу
+ * (например, словарь) можно разделять между потоками.
+ */
+struct CodeTable {
+    /** @brief Частоты символов (0 — символ отсутствует). */
+    uint64_t freq[256];
+
+    /** @brief Длины кодов символов (0 — символ отсутствует). */
+    uint8_t lengths[256];
+
+    /** @brief Канонические коды символов (младшие lengths[s] бит). */
+    uint16_t codes[256];
+
+    /**
+     * @brief Таблица декодирования на 2^table_bits записей.
+     *
+     * Запись — символ в младшем байте и длина кода в старшем; длина 0 означает
+     * недопустимый префикс, а запись kEscapeEntry — код длиннее table_bits, который
+     * дочитывается по каноническим диапазонам (first_code, first_index).
+     */
+    uint16_t decode_table[1u << kMaxCodeLength];
+
+    /** @brief Символы в каноническом порядке: по возрастанию длины кода, затем символа. */
+    uint8_t sorted_symbols[256];
+
+    /** @brief Первый канонический код каждой длины. */
+    uint16_t first_code[kMaxCodeLength + 1];
+
+    /** @brief Позиция первого символа каждой длины в sorted_symbols (first_index[len + 1] — конец диапазона). */
+    uint16_t first_index[kMaxCodeLength + 2];
+
+    /** @brief Число символов с ненулевой частотой. */
+    unsigned symbol_count = 0;
+
+    /** @brief Максимальная длина кода в таблице. */
+    unsigned max_length = 0;
+
+    /**
+     * @brief Ширина индекса таблицы декодирования.
+     *
+     * Обычно max_length, округленная до 8, 10, 11 или 12. Если символов по частотам
+     * меньше, чем записей в такой таблице (маленький блок), таблица строится на 8 бит,
+     * а более длинные коды декодируются через kEscapeEntry: заполнение таблицы иначе
+     * стоило бы дороже самого декодирования.
+     */
+    unsigned table_bits = 0;
+
+    /** @brief Ограничивать длины оптимально (package-merge), а не эвристикой. */
+    bool optimal_lengths = false;
+
+    CodeTable();
+
+    /**
+     * @brief Строит только длины кодов по частотам (без кодов и таблицы декодирования).
+     *
+     * Достаточно для оценки размера закодированных данных через encodedBits().
+     */
+    void buildLengths();
+
+    /**
+     * @brief Строит канонические коды и их упорядочение по готовым длинам.
+     *
+     * Достаточно для кодирования через encodeBits().
+     *
+     * @throws std::runtime_error Если длины кодов нарушают неравенство Крафта.
+     */
+    void buildCodes();
+
+    /**
+     * @brief Выбирает table_bits и заполняет таблицу декодирования по каноническим кодам.
+     *
+     * Коды идут в таблице подряд в порядке sorted_symbols, поэтому заполнение —
+     * последовательная запись диапазонов без предварительного обнуления.
+     */
+    void buildDecodeTable();
+
+    /**
+     * @brief Строит длины, канонические коды и таблицу декодирования по частотам.
+     * @throws std::runtime_error Если длины кодов нарушают неравенство Крафта.
+     */
+    void build();
+
+    /**
+     * @brief Возвращает размер битового потока для текущих частот и длин кодов.
+     * @return Размер в битах.
+     */
+    uint64_t encodedBits() const;
+
+    /**
+     * @brief Возвращает размер сериализованной таблицы частот.
+     * @return Размер в байтах.
+     */
+    size_t frequencyTableSize() const { return 4 + symbol_count * 9; }
+
+    /**
+     * @brief Записывает таблицу частот.
+     * @param out Буфер размером не менее frequencyTableSize() байт.
+     * @return Число записанных байт.
+     */
+    size_t writeFrequencyTable(unsigned char* out) const;
+
+    /**
+     * @brief Считывает таблицу частот из полезной нагрузки блока.
+     *
+     * Таблица проверяется до построения кодов: от 1 до 256 записей, без повторов
+     * символов и нулевых частот, сумма частот помещается в uint64_t.
+     *
+     * @param in Начало полезной нагрузки.
+     * @param size Размер полезной нагрузки.
+     * @return Число байт, занятых таблицей.
+     * @throws std::runtime_error Если таблица частот повреждена.
+     */
+    size_t readFrequencyTable(const unsigned char* in, size_t size);
+
+    /**
+     * @brief Кодирует данные в битовый поток.
+     *
+     * Кодирует по четыре символа за шаг без ветвлений и записывает 64-битное слово
+     * целиком, поэтому может затронуть до 8 байт за концом результата; запас на
+     * это заложен в encodedBound().
+     *
+     * @param data Исходные данные; все символы должны иметь коды.
+     * @param size Размер исходных данных.
+     * @param out Буфер размером не менее encodedBound(size) байт.
+     * @return Число записанных байт.
+     */
+    size_t encodeBits(const unsigned char* data, size_t size, unsigned char* out) const;
+
+    /**
+     * @brief Декодирует битовый поток.
+     *
+     * Цикл декодирования специализирован по ширине таблицы (table_bits): сдвиги и число
+     * символов на одно чтение 64-битного слова — константы, поэтому внутренний цикл
+     * разворачивается компилятором. Нужная специализация выбирается по таблице блока.
+     *
+     * @param in Начало битового потока.
+     * @param size Размер битового потока в байтах.
+     * @param out Буфер для raw_size декодированных символов.
+     * @param raw_size Число символов, которое нужно декодировать.
+     * @throws std::runtime_error Если поток поврежден или закончился раньше времени.
+     */
+    void decodeBits(const unsigned char* in, size_t size, unsigned char* out, size_t raw_size) const;
+
+    /**
+     * @brief Возвращает верхнюю границу размера битового потока.
+     * @param size Размер исходных данных.
+     * @return Размер в байтах.
+     */
+    static size_t encodedBound(size_t size) { return (size * kMaxCodeLength + 7) / 8 + 8; }
+
+    /**
+     * @brief Представляет коды в виде строк из '0' и '1' (для тестов и отладки).
+     * @return Карта символов и их кодов.
+     */
+    std::map<unsigned char, std::string> toCodeMap() const;
+};
+
+class Dictionary;
+struct WideCodeTable;
+
+/**
+ * @class BlockCodec
+ * @brief Кодирует и декодирует один блок архива.
+ *
+ * Экземпляр хранит таблицу последнего обработанного блока и переиспользует ее,
+ * не выделяя память. Он не потокобезопасен: каждому рабочему потоку нужен
+ * собственный экземпляр.
+ */
+class BlockCodec {
+private:
+    /** @brief Таблица текущего блока. */
+    CodeTable table;
+
+    /** @brief Рабочая таблица для оценки стоимости кандидатов при разбиении. */
+    CodeTable planner;
+
+    /** @brief Содержит ли table таблицу предыдущего блока, которую можно переиспользовать. */
+    bool has_table = false;
+
+    /** @brief Таблица 16-битных символов; создается при первом блоке BlockMode::Wide. */
+    std::unique_ptr<WideCodeTable> wide;
+
+    /** @brief Пробовать режим BlockMode::Wide при кодировании. */
+    bool wide_symbols = false;
+
+    /**
+     * @brief Строит длины кодов 16-битных символов блока и оценивает размер полезной нагрузки.
+     * @param data Исходные данные блока.
+     * @param size Размер исходных данных (не меньше 2).
+     * @return Размер полезной нагрузки BlockMode::Wide в байтах.
+     */
+    uint64_t wideCost(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Оценивает размер блока с заданной гистограммой: таблица частот и битовый поток.
+     * @param counts Гистограмма из 256 счетчиков.
+     * @return Размер в битах.
+     */
+    uint64_t estimateCost(const uint64_t* counts);
+
+    /**
+     * @brief Оценивает размер битового потока блока при кодировании таблицей предыдущего блока.
+     * @param counts Гистограмма блока.
+     * @return Размер в битах; UINT64_MAX, если таблицы нет или в ней нет кода для символа блока.
+     */
+    uint64_t reuseCost(const uint64_t* counts) const;
+
+    /**
+     * @brief Кодирует один блок с заголовком в самом дешевом режиме.
+     *
+     * Блок из одного символа записывается в режиме Rle. При включенных 16-битных
+     * символах блок записывается в режиме Wide, если так он меньше и исходных данных,
+     * и оценки побайтового кодирования. Если энтропия гистограммы
+     * вместе с таблицей не дает выигрыша перед исходными данными, блок копируется
+     * в режиме Stored без построения кодов; он же используется, если закодированный
+     * поток все-таки оказался не меньше исходных данных.
+     * @param data Исходные данные блока.
+     * @param size Размер исходных данных.
+     * @param counts Гистограмма блока.
+     * @param out Выходной буфер.
+     * @return Число записанных байт.
+     */
+    size_t encodeBlock(const unsigned char* data, size_t size, const uint64_t* counts, unsigned char* out);
+
+public:
+    BlockCodec();
+    ~BlockCodec();
+
+    /**
+     * @brief Возвращает наибольшее число блоков, которое может выдать один вызов encode().
+     * @param size Размер исходных данных.
+     * @return Число блоков.
+     */
+    static size_t maxBlocks(size_t size) { return size / kMinSplitSegmentSize + 1; }
+
+    /**
+     * @brief Возвращает верхнюю границу размера закодированных данных с заголовками блоков.
+     * @param size Размер исходных данных.
+     * @return Размер в байтах.
+     */
+    static size_t encodeBound(size_t size) {
+        return maxBlocks(size) * (frame::kBlockHeaderSize + 4 + 256 * 9) + CodeTable::encodedBound(size);
+    }
+
+    /**
+     * @brief Кодирует данные в один или несколько блоков с заголовками.
+     *
+     * В заголовок каждого блока записывается CRC32C его исходных данных. Со словарем
+     * данные кодируются его готовыми кодами одним блоком, и таблица частот в блок
+     * не записывается.
+     *
+     * Блок из одного символа записывается в режиме BlockMode::Rle, а несжимаемый
+     * по оценке энтропии — в режиме BlockMode::Stored.
+     *
+     * Если кодирование таблицей предыдущего блока (с момента reset()) по оценке
+     * не дороже новой таблицы вместе с ее записью, блок записывается в режиме
+     * BlockMode::Repeat без таблицы частот.
+     *
+     * При адаптивном разбиении данные делятся на сегменты по split_segment байт.
+     * Очередной сегмент присоединяется к текущему блоку, если оценка стоимости
+     * объединения (по длинам кодов, без кодирования) не больше суммы стоимостей
+     * по отдельности; иначе на его границе начинается новый блок. Гистограммы
+     * сегментов суммируются и повторно не считаются.
+     *
+     * @param data Исходные данные.
+     * @param size Размер исходных данных (больше 0).
+     * @param out Буфер размером не менее encodeBound(size) байт.
+     * @param dictionary Словарь или nullptr.
+     * @param split_segment Размер сегмента адаптивного разбиения (0 — без разбиения;
+     *        меньшие значения округляются до kMinSplitSegmentSize).
+     * @return Число записанных байт.
+     */
+    size_t encode(const unsigned char* data, size_t size, unsigned char* out, const Dictionary* dictionary = nullptr, size_t split_segment = 0);
+
+    /**
+     * @brief Кодирует данные и дописывает блоки (с заголовками) в конец буфера.
+     * @param data Исходные данные.
+     * @param size Размер исходных данных (больше 0).
+     * @param out Буфер; его емкость переиспользуется между вызовами.
+     * @param dictionary Словарь или nullptr.
+     * @param split_segment Размер сегмента адаптивного разбиения (0 — без разбиения).
+     */
+    void encode(const unsigned char* data, size_t size, std::vector<unsigned char>& out, const Dictionary* dictionary = nullptr, size_t split_segment = 0);
+
+    /**
+     * @brief Выбирает алгоритм ограничения длин кодов для собственных таблиц блоков.
+     *
+     * Кодировщик и декодер должны использовать одно значение; архив сообщает его
+     * флагом kFlagOptimalLengths.
+     *
+     * @param optimal true — package-merge, false — эвристика.
+     */
+    void setOptimalLengths(bool optimal) { table.optimal_lengths = planner.optimal_lengths = optimal; }
+
+    /**
+     * @brief Включает пробу режима BlockMode::Wide для следующих блоков.
+     * @param enabled true — сравнивать с кодами 16-битных символов.
+     */
+    void setWideSymbols(bool enabled) { wide_symbols = enabled; }
+
+    /**
+     * @brief Забывает таблицу предыдущего блока.
+     *
+     * Вызывается в начале каждого независимо декодируемого участка: следующий
+     * блок получит собственную таблицу.
+     */
+    void reset() { has_table = false; }
+
+    /**
+     * @brief Строит таблицу по таблице частот из полезной нагрузки блока режима Huffman.
+     *
+     * Нужна для декодирования блока BlockMode::Repeat без декодирования блока,
+     * которому принадлежит таблица.
+     *
+     * @param payload Полезная нагрузка блока с собственной таблицей.
+     * @param size Размер полезной нагрузки.
+     * @return Число байт, занятых таблицей частот.
+     * @throws std::runtime_error Если таблица частот повреждена или пуста.
+     */
+    size_t loadTable(const unsigned char* payload, size_t size);
+
+    /**
+     * @brief Декодирует полезную нагрузку блока.
+     *
+     * Блок BlockMode::Repeat декодируется уже построенной таблицей без ее перестроения.
+     *
+     * @param header Заголовок блока.
+     * @param payload Полезная нагрузка блока.
+     * @param out Буфер размером не менее header.raw_size байт.
+     * @param dictionary Словарь архива или nullptr.
+     * @throws std::runtime_error Если блок поврежден, его контрольная сумма не совпадает,
+     *         он ссылается на отсутствующий словарь или на отсутствующую таблицу предыдущего блока.
+     */
+    void decode(const frame::BlockHeader& header, const unsigned char* payload, unsigned char* out, const Dictionary* dictionary = nullptr);
+
+    /**
+     * @brief Возвращает таблицу последнего блока с собственной таблицей.
+     * @return Константная ссылка на таблицу.
+     */
+    const CodeTable& getTable() const { return table; }
+};
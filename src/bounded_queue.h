@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * @file bounded_queue.h
+ * @brief Потокобезопасная очередь ограниченной емкости для связи стадий конвейера.
+ */
+
+/**
+ * @class BoundedQueue
+ * @brief Очередь FIFO с блокирующими push/pop и ограничением на число элементов.
+ *
+ * Производитель блокируется, пока очередь заполнена, поэтому объем данных
+ * между стадиями конвейера ограничен. После close() новые элементы не принимаются,
+ * а pop() возвращает оставшиеся элементы и затем сообщает о завершении.
+ *
+ * Элементы хранятся в кольцевом буфере, выделенном при создании, поэтому
+ * push()/pop() не обращаются к распределителю памяти.
+ *
+ * @tparam T Тип элемента.
+ */
+template <typename T>
+class BoundedQueue {
+private:
+    /** @brief Кольцевой буфер элементов (его размер — емкость очереди). */
+    std::vector<T> items;
+
+    /** @brief Позиция первого элемента в кольцевом буфере. */
+    size_t head = 0;
+
+    /** @brief Число элементов в очереди. */
+    size_t count = 0;
+
+    /** @brief Признак закрытой очереди. */
+    bool closed = false;
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+
+public:
+    /**
+     * @brief Создает очередь заданной емкости.
+     * @param capacity Максимальное число элементов (не меньше 1).
+     */
+    explicit BoundedQueue(size_t capacity) : items(capacity ? capacity : 1) {}
+
+    /**
+     * @brief Добавляет элемент, ожидая свободного места.
+     * @param item Добавляемый элемент.
+     * @return false, если очередь закрыта и элемент не добавлен.
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return closed || count < items.size(); });
+        if (closed) return false;
+        items[(head + count++) % items.size()] = std::move(item);
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Извлекает элемент, ожидая его появления.
+     * @param item Сюда помещается извлеченный элемент.
+     * @return false, если очередь закрыта и пуста.
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return closed || count > 0; });
+        if (count == 0) return false;
+        item = std::move(items[head]);
+        head = (head + 1) % items.size();
+        --count;
+        not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Закрывает очередь и будит все ожидающие потоки.
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+};
@@ -0,0 +1,118 @@
+#include "checksum.h"
+#include "cpu_dispatch.h"
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <nmmintrin.h>
+#define HUFFMAN_HAVE_SSE42 1
+#endif
+
+namespace {
+
+constexpr uint32_t kPolynomial = 0x82F63B78;
+
+struct Tables {
+    uint32_t t[8][256];
+
+    Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1)));
+            t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+        }
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+#ifdef HUFFMAN_HAVE_SSE42
+__attribute__((target("sse4.2")))
+uint32_t crc32cSse42(uint32_t crc, const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t state = ~crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        state = _mm_crc32_u64(state, word);
+    }
+    uint32_t tail = static_cast<uint32_t>(state);
+    for (; size > 0; ++p, --size) tail = _mm_crc32_u8(tail, *p);
+    return ~tail;
+}
+#endif
+
+using Crc32cFunction = uint32_t (*)(uint32_t, const void*, size_t);
+
+Crc32cFunction crc32cImpl() {
+#ifdef HUFFMAN_HAVE_SSE42
+    if (activeKernelSet() != KernelSet::Generic) return crc32cSse42;
+#endif
+    return crc32cSoftware;
+}
+
+uint32_t gf2Times(const uint32_t* matrix, uint32_t vector) {
+    uint32_t sum = 0;
+    for (; vector; vector >>= 1, ++matrix) {
+        if (vector & 1) sum ^= *matrix;
+    }
+    return sum;
+}
+
+void gf2Square(uint32_t* square, const uint32_t* matrix) {
+    for (int n = 0; n < 32; ++n) square[n] = gf2Times(matrix, matrix[n]);
+}
+
+}
+
+uint32_t crc32cSoftware(uint32_t crc, const void* data, size_t size) {
+    const Tables& tab = tables();
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint32_t low, high;
+        std::memcpy(&low, p, 4);
+        std::memcpy(&high, p + 4, 4);
+        low ^= crc;
+        crc = tab.t[7][low & 0xFF] ^ tab.t[6][(low >> 8) & 0xFF] ^ tab.t[5][(low >> 16) & 0xFF] ^ tab.t[4][low >> 24] ^
+              tab.t[3][high & 0xFF] ^ tab.t[2][(high >> 8) & 0xFF] ^ tab.t[1][(high >> 16) & 0xFF] ^ tab.t[0][high >> 24];
+    }
+    for (; size > 0; ++p, --size) crc = (crc >> 8) ^ tab.t[0][(crc ^ *p) & 0xFF];
+    return ~crc;
+}
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t size) {
+    return crc32cImpl()(crc, data, size);
+}
+
+bool crc32cHardware() {
+    return crc32cImpl() != crc32cSoftware;
+}
+
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, uint64_t size2) {
+    if (size2 == 0) return crc1;
+    // Сдвиг crc1 на size2 байт линеен, поэтому для первого фрагмента архива (crc1 == 0) он не нужен.
+    if (crc1 == 0) return crc2;
+
+    uint32_t even[32], odd[32];
+    odd[0] = kPolynomial;
+    for (int n = 1; n < 32; ++n) odd[n] = 1u << (n - 1);
+    gf2Square(even, odd);
+    gf2Square(odd, even);
+
+    do {
+        gf2Square(even, odd);
+        if (size2 & 1) crc1 = gf2Times(even, crc1);
+        size2 >>= 1;
+        if (size2 == 0) break;
+        gf2Square(odd, even);
+        if (size2 & 1) crc1 = gf2Times(odd, crc1);
+        size2 >>= 1;
+    } while (size2 != 0);
+    return crc1 ^ crc2;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file checksum.h
+ * @brief Контрольные суммы CRC32C (полином Кастаньоли) для блоков и содержимого архива.
+ */
+
+/**
+ * @brief Продолжает CRC32C над очередным фрагментом данных.
+ *
+ * На процессорах x86-64 с SSE4.2 используется аппаратная инструкция crc32,
+ * иначе — табличный алгоритм, обрабатывающий по 8 байт за шаг. Вариант
+ * определяется активным набором ядер (см. activeKernelSet()).
+ *
+ * @param crc CRC32C предыдущих данных (0 для начала).
+ * @param data Данные.
+ * @param size Размер данных.
+ * @return CRC32C данных, дописанных к предыдущим.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t size);
+
+/**
+ * @brief Табличная реализация crc32c() без аппаратного ускорения.
+ * @param crc CRC32C предыдущих данных (0 для начала).
+ * @param data Данные.
+ * @param size Размер данных.
+ * @return CRC32C данных, дописанных к предыдущим.
+ */
+uint32_t crc32cSoftware(uint32_t crc, const void* data, size_t size);
+
+/**
+ * @brief Объединяет CRC32C двух соседних фрагментов.
+ *
+ * Позволяет считать суммы блоков независимо (в разных потоках) и получать
+ * из них сумму всего содержимого за O(log size2) без повторного чтения данных.
+ *
+ * @param crc1 CRC32C первого фрагмента.
+ * @param crc2 CRC32C второго фрагмента.
+ * @param size2 Размер второго фрагмента.
+ * @return CRC32C склейки фрагментов.
+ */
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, uint64_t size2);
+
+/**
+ * @brief Сообщает, используется ли аппаратное ускорение CRC32C.
+ * @return true, если crc32c() использует инструкции SSE4.2.
+ */
+bool crc32cHardware();
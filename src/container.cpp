@@ -0,0 +1,363 @@
+#include "container.h"
+#include "block_codec.h"
+#include "huffman_context.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kContainerMagic = 0x41465548; // "HUFA"
+constexpr uint32_t kDirectoryMagic = 0x45465548; // "HUFE"
+constexpr uint8_t kContainerVersion = 1;
+constexpr size_t kContainerHeaderSize = 5;
+constexpr size_t kFooterSize = 16;
+constexpr size_t kEntryFixedSize = 2 + 8 + 4 + 8 + 8 + 8;
+constexpr uint64_t kTreeRoundSize = 64 << 20;
+constexpr uint64_t kExtractTaskSize = 1 << 20;
+
+// Эпохи часов файловой системы и системных часов отличаются на целое число секунд; округление
+// убирает разницу между двумя вызовами now(), из-за которой время могло сдвинуться на секунду.
+std::chrono::seconds fileClockOffset() {
+    return std::chrono::round<std::chrono::seconds>(fs::file_time_type::clock::now().time_since_epoch() -
+                                                    std::chrono::system_clock::now().time_since_epoch());
+}
+
+int64_t toUnixSeconds(fs::file_time_type time) {
+    return (std::chrono::floor<std::chrono::seconds>(time.time_since_epoch()) - fileClockOffset()).count();
+}
+
+fs::file_time_type fromUnixSeconds(int64_t seconds) {
+    return fs::file_time_type(std::chrono::duration_cast<fs::file_time_type::duration>(std::chrono::seconds(seconds) + fileClockOffset()));
+}
+
+bool isSafeMemberName(const std::string& name) {
+    fs::path path(name);
+    if (path.is_absolute() || path.has_root_name() || path.has_root_directory()) return false;
+    for (const auto& part : path) {
+        if (part == "..") return false;
+    }
+    return true;
+}
+
+void write(std::ostream& out, const void* data, size_t size) {
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+}
+
+std::vector<TreeFile> walkTree(const std::string& directory, unsigned threads) {
+    if (!fs::is_directory(directory)) throw std::runtime_error("Not a directory: " + directory);
+    std::vector<TreeFile> files;
+    std::mutex files_mutex;
+    std::function<void(fs::path, std::string)> visit;
+    WorkStealingPool pool(threads);
+    visit = [&](fs::path path, std::string prefix) {
+        std::vector<TreeFile> found;
+        std::error_code ec;
+        for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+            const fs::directory_entry& entry = *it;
+            if (entry.is_symlink(ec)) continue;
+            std::string name = prefix + entry.path().filename().generic_string();
+            if (entry.is_directory(ec)) {
+                pool.submit([&visit, child = entry.path(), name](unsigned) { visit(child, name + "/"); });
+            } else if (entry.is_regular_file(ec)) {
+                found.push_back({entry.path().string(), name, entry.file_size(ec)});
+            }
+        }
+        if (ec) throw std::runtime_error("Failed to read directory: " + path.string());
+        std::lock_guard<std::mutex> lock(files_mutex);
+        files.insert(files.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    };
+    pool.submit([&](unsigned) { visit(directory, ""); });
+    pool.wait();
+    std::sort(files.begin(), files.end(), [](const TreeFile& a, const TreeFile& b) { return a.name < b.name; });
+    return files;
+}
+
+ArchiveWriter::ArchiveWriter(const std::string& archive_file) : out(archive_file, std::ios::binary) {
+    if (!out) throw std::runtime_error("Error opening files");
+    unsigned char header[kContainerHeaderSize];
+    frame::putU32(header, kContainerMagic);
+    header[4] = kContainerVersion;
+    write(out, header, sizeof(header));
+}
+
+void ArchiveWriter::reserveName(const std::string& name) {
+    if (finished) throw std::runtime_error("Archive is already finished");
+    if (name.empty() || name.size() > UINT16_MAX || !isSafeMemberName(name)) throw std::runtime_error("Invalid member name");
+    if (!names.insert(name).second) throw std::runtime_error("Duplicate member name: " + name);
+}
+
+void ArchiveWriter::add(const std::string& input_file, const std::string& name, const CompressOptions& options) {
+    std::ifstream in(input_file, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open input file");
+    reserveName(name);
+
+    ArchiveEntry entry;
+    entry.name = name;
+    entry.size = fs::file_size(input_file);
+    entry.mode = static_cast<uint32_t>(fs::status(input_file).permissions());
+    entry.mtime = toUnixSeconds(fs::last_write_time(input_file));
+    entry.offset = static_cast<uint64_t>(out.tellp());
+
+    if (entry.size > 0) HuffmanArchiver().compressStream(in, out, options);
+    if (!out) throw std::runtime_error("Failed to write output file");
+    entry.compressed_size = static_cast<uint64_t>(out.tellp()) - entry.offset;
+    entries.push_back(std::move(entry));
+}
+
+void ArchiveWriter::addTree(const std::string& directory, const CompressOptions& options) {
+    if (options.block_size == 0 || options.block_size > frame::kMaxBlockSize) throw std::runtime_error("Invalid block size");
+    std::vector<TreeFile> files = walkTree(directory, options.threads);
+
+    struct Worker {
+        HuffmanContext context;
+        std::vector<unsigned char> raw;
+        std::vector<unsigned char> scratch;
+    };
+    struct Member {
+        ArchiveEntry entry;
+        std::vector<unsigned char> encoded;
+    };
+    WorkStealingPool pool(options.threads);
+    std::vector<std::unique_ptr<Worker>> workers(pool.size());
+    auto compressSmall = [&](Worker& worker, const TreeFile& file, Member& member) {
+        std::ifstream in(file.path, std::ios::binary);
+        if (!in) throw std::runtime_error("Failed to open input file: " + file.path);
+        member.entry.name = file.name;
+        member.entry.size = fs::file_size(file.path);
+        member.entry.mode = static_cast<uint32_t>(fs::status(file.path).permissions());
+        member.entry.mtime = toUnixSeconds(fs::last_write_time(file.path));
+        if (member.entry.size == 0) return;
+        worker.raw.resize(static_cast<size_t>(member.entry.size));
+        if (!in.read(reinterpret_cast<char*>(worker.raw.data()), worker.raw.size())) {
+            throw std::runtime_error("Failed to read input file: " + file.path);
+        }
+        worker.scratch.resize(HuffmanContext::compressBound(worker.raw.size(), options.block_size));
+        size_t size = worker.context.compress(worker.raw.data(), worker.raw.size(), worker.scratch.data(), worker.scratch.size(), options);
+        member.encoded.assign(worker.scratch.begin(), worker.scratch.begin() + size);
+    };
+
+    // Маленькие файлы сжимаются раундами в память и записываются по порядку; большие — по одному конвейером.
+    for (size_t i = 0; i < files.size();) {
+        if (files[i].size > options.block_size) {
+            add(files[i].path, files[i].name, options);
+            ++i;
+            continue;
+        }
+        size_t end = i;
+        uint64_t round_bytes = 0;
+        while (end < files.size() && files[end].size <= options.block_size && round_bytes < kTreeRoundSize) {
+            reserveName(files[end].name);
+            round_bytes += files[end++].size;
+        }
+        std::vector<Member> members(end - i);
+        for (size_t first = i; first < end;) {
+            size_t last = first;
+            for (uint64_t task_bytes = 0; last < end && (last == first || task_bytes < options.block_size);) task_bytes += files[last++].size;
+            pool.submit([&, first, last, base = i](unsigned index) {
+                if (!workers[index]) workers[index] = std::make_unique<Worker>();
+                for (size_t k = first; k < last; ++k) compressSmall(*workers[index], files[k], members[k - base]);
+            });
+            first = last;
+        }
+        pool.wait();
+        for (auto& member : members) {
+            member.entry.offset = static_cast<uint64_t>(out.tellp());
+            write(out, member.encoded.data(), member.encoded.size());
+            if (!out) throw std::runtime_error("Failed to write output file");
+            member.entry.compressed_size = member.encoded.size();
+            entries.push_back(std::move(member.entry));
+        }
+        i = end;
+    }
+}
+
+void ArchiveWriter::finish() {
+    if (finished) return;
+    uint64_t directory_offset = static_cast<uint64_t>(out.tellp());
+    std::vector<unsigned char> directory;
+    for (const auto& entry : entries) {
+        size_t pos = directory.size();
+        directory.resize(pos + kEntryFixedSize + entry.name.size());
+        unsigned char* p = &directory[pos];
+        uint16_t name_size = static_cast<uint16_t>(entry.name.size());
+        std::memcpy(p, &name_size, 2);
+        std::memcpy(p + 2, entry.name.data(), entry.name.size());
+        p += 2 + entry.name.size();
+        frame::putU64(p, entry.size);
+        frame::putU32(p + 8, entry.mode);
+        frame::putU64(p + 12, static_cast<uint64_t>(entry.mtime));
+        frame::putU64(p + 20, entry.offset);
+        frame::putU64(p + 28, entry.compressed_size);
+    }
+    write(out, directory.data(), directory.size());
+
+    unsigned char footer[kFooterSize];
+    frame::putU64(footer, directory_offset);
+    frame::putU32(footer + 8, static_cast<uint32_t>(entries.size()));
+    frame::putU32(footer + 12, kDirectoryMagic);
+    write(out, footer, sizeof(footer));
+    out.flush();
+    if (!out) throw std::runtime_error("Failed to write output file");
+    finished = true;
+}
+
+bool ArchiveReader::isContainer(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char magic[4];
+    return in.read(reinterpret_cast<char*>(magic), sizeof(magic)) && frame::getU32(magic) == kContainerMagic;
+}
+
+ArchiveReader::ArchiveReader(const std::string& archive_file) : archive_file(archive_file) {
+    std::ifstream in(archive_file, std::ios::binary);
+    if (!in) throw std::runtime_error("Error opening files");
+
+    unsigned char header[kContainerHeaderSize];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || frame::getU32(header) != kContainerMagic) {
+        throw std::runtime_error("Unsupported archive format");
+    }
+    if (header[4] != kContainerVersion) throw std::runtime_error("Unsupported archive version");
+
+    uint64_t file_size = fs::file_size(archive_file);
+    if (file_size < kContainerHeaderSize + kFooterSize) throw std::runtime_error("Corrupted archive: missing directory");
+    unsigned char footer[kFooterSize];
+    in.seekg(static_cast<std::streamoff>(file_size - kFooterSize));
+    if (!in.read(reinterpret_cast<char*>(footer), sizeof(footer)) || frame::getU32(footer + 12) != kDirectoryMagic) {
+        throw std::runtime_error("Corrupted archive: missing directory");
+    }
+    uint64_t directory_offset = frame::getU64(footer);
+    uint32_t count = frame::getU32(footer + 8);
+    uint64_t directory_end = file_size - kFooterSize;
+    if (directory_offset < kContainerHeaderSize || directory_offset > directory_end) {
+        throw std::runtime_error("Corrupted archive: invalid directory offset");
+    }
+
+    std::vector<unsigned char> directory(static_cast<size_t>(directory_end - directory_offset));
+    in.seekg(static_cast<std::streamoff>(directory_offset));
+    if (!in.read(reinterpret_cast<char*>(directory.data()), directory.size())) {
+        throw std::runtime_error("Corrupted archive: failed to read directory");
+    }
+
+    size_t pos = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (directory.size() - pos < kEntryFixedSize) throw std::runtime_error("Corrupted archive: truncated directory");
+        uint16_t name_size;
+        std::memcpy(&name_size, &directory[pos], 2);
+        if (name_size == 0 || directory.size() - pos < kEntryFixedSize + name_size) {
+            throw std::runtime_error("Corrupted archive: truncated directory");
+        }
+        ArchiveEntry entry;
+        entry.name.assign(reinterpret_cast<const char*>(&directory[pos + 2]), name_size);
+        const unsigned char* p = &directory[pos + 2 + name_size];
+        entry.size = frame::getU64(p);
+        entry.mode = frame::getU32(p + 8);
+        entry.mtime = static_cast<int64_t>(frame::getU64(p + 12));
+        entry.offset = frame::getU64(p + 20);
+        entry.compressed_size = frame::getU64(p + 28);
+        if (entry.offset < kContainerHeaderSize || entry.offset > directory_offset ||
+            entry.compressed_size > directory_offset - entry.offset) {
+            throw std::runtime_error("Corrupted archive: member outside of data area");
+        }
+        // Сжатое содержимое пусто ровно у пустых файлов; иначе член указывал бы на байты соседнего.
+        if ((entry.compressed_size == 0) != (entry.size == 0)) throw std::runtime_error("Corrupted archive: member size mismatch");
+        if (!isSafeMemberName(entry.name)) throw std::runtime_error("Corrupted archive: unsafe member name");
+        if (!by_name.emplace(entry.name, entries.size()).second) {
+            throw std::runtime_error("Corrupted archive: duplicate member name");
+        }
+        entries.push_back(std::move(entry));
+        pos += kEntryFixedSize + name_size;
+    }
+    if (pos != directory.size()) throw std::runtime_error("Corrupted archive: trailing data in directory");
+}
+
+const ArchiveEntry* ArchiveReader::find(const std::string& name) const {
+    auto it = by_name.find(name);
+    return it == by_name.end() ? nullptr : &entries[it->second];
+}
+
+void ArchiveReader::extract(const ArchiveEntry& entry, const std::string& output_file) const {
+    std::ifstream in(archive_file, std::ios::binary);
+    std::ofstream out(output_file, std::ios::binary);
+    if (!in || !out) throw std::runtime_error("Error opening files");
+    in.seekg(static_cast<std::streamoff>(entry.offset));
+    if (entry.compressed_size > 0) {
+        HuffmanArchiver archiver;
+        for (const auto& dictionary : dictionaries) archiver.addDictionary(dictionary);
+        archiver.decompressStream(in, out);
+    }
+    out.close();
+    if (!out) throw std::runtime_error("Failed to write output file");
+    if (static_cast<uint64_t>(fs::file_size(output_file)) != entry.size) {
+        throw std::runtime_error("Corrupted archive: member size mismatch");
+    }
+    std::error_code ec;
+    fs::permissions(output_file, static_cast<fs::perms>(entry.mode) & fs::perms::mask, ec);
+    fs::last_write_time(output_file, fromUnixSeconds(entry.mtime), ec);
+}
+
+void ArchiveReader::extract(const std::string& name, const std::string& output_file) const {
+    const ArchiveEntry* entry = find(name);
+    if (!entry) throw std::runtime_error("No such member: " + name);
+    extract(*entry, output_file);
+}
+
+void ArchiveReader::extractAll(const std::string& directory, unsigned threads) const {
+    std::set<fs::path> parents;
+    for (const auto& entry : entries) {
+        fs::path target = fs::path(directory) / fs::path(entry.name);
+        if (target.has_parent_path() && parents.insert(target.parent_path()).second) fs::create_directories(target.parent_path());
+    }
+
+    WorkStealingPool pool(threads);
+    for (size_t first = 0; first < entries.size();) {
+        size_t last = first;
+        for (uint64_t task_bytes = 0; last < entries.size() && (last == first || task_bytes < kExtractTaskSize);) {
+            task_bytes += entries[last++].compressed_size;
+        }
+        pool.submit([this, &directory, first, last](unsigned) {
+            for (size_t i = first; i < last; ++i) extract(entries[i], (fs::path(directory) / fs::path(entries[i].name)).string());
+        });
+        first = last;
+    }
+    pool.wait();
+}
+
+void ArchiveReader::verify(unsigned threads) const {
+    std::ifstream in(archive_file, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open input file");
+    HuffmanArchiver archiver;
+    for (const auto& dictionary : dictionaries) archiver.addDictionary(dictionary);
+    for (const auto& entry : entries) {
+        if (entry.compressed_size == 0) continue;
+        try {
+            in.seekg(static_cast<std::streamoff>(entry.offset));
+            if (archiver.verifyStream(in, threads) != entry.size) {
+                throw std::runtime_error("Corrupted archive: member size mismatch");
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error(entry.name + ": " + e.what());
+        }
+    }
+}
+
+uint64_t ArchiveReader::extractRange(const std::string& name, uint64_t offset, uint64_t length, const std::string& output_file) const {
+    const ArchiveEntry* entry = find(name);
+    if (!entry) throw std::runtime_error("No such member: " + name);
+    if (entry->compressed_size == 0) throw std::runtime_error("Range is outside of archive content");
+    std::ifstream in(archive_file, std::ios::binary);
+    std::ofstream out(output_file, std::ios::binary);
+    if (!in || !out) throw std::runtime_error("Error opening files");
+    in.seekg(static_cast<std::streamoff>(entry->offset));
+    HuffmanArchiver archiver;
+    for (const auto& dictionary : dictionaries) archiver.addDictionary(dictionary);
+    return archiver.extractRangeStream(in, entry->compressed_size, offset, length, out);
+}
@@ -0,0 +1,249 @@
+#pragma once
+#include "huffman.h"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @file container.h
+ * @brief Многофайловый контейнер .huffa с центральным каталогом в конце.
+ *
+ * Раскладка (все числа little-endian):
+ * - заголовок: магическое число "HUFA", версия (1 байт);
+ * - данные членов: каждый непустой член — самостоятельный архив .huff;
+ * - центральный каталог: для каждого члена длина имени (uint16), имя (UTF-8,
+ *   разделитель '/'), исходный размер (uint64), режим доступа (uint32),
+ *   время изменения в секундах Unix (int64), смещение архива члена (uint64),
+ *   размер архива члена (uint64);
+ * - хвост: смещение каталога (uint64), число членов (uint32), магическое число "HUFE".
+ *
+ * Каталог читается по хвосту, поэтому список членов и переход к любому из них
+ * не требуют чтения данных архива.
+ */
+
+/**
+ * @brief Запись центрального каталога контейнера.
+ */
+struct ArchiveEntry {
+    /** @brief Имя члена (относительный путь с разделителем '/'). */
+    std::string name;
+
+    /** @brief Исходный размер в байтах. */
+    uint64_t size = 0;
+
+    /** @brief Режим доступа (биты прав std::filesystem::perms). */
+    uint32_t mode = 0;
+
+    /** @brief Время последнего изменения в секундах Unix. */
+    int64_t mtime = 0;
+
+    /** @brief Смещение архива члена от начала контейнера. */
+    uint64_t offset = 0;
+
+    /** @brief Размер архива члена в байтах. */
+    uint64_t compressed_size = 0;
+};
+
+/**
+ * @brief Обычный файл, найденный при обходе дерева каталогов.
+ */
+struct TreeFile {
+    /** @brief Путь к файлу на диске. */
+    std::string path;
+
+    /** @brief Путь относительно корня обхода с разделителем '/'. */
+    std::string name;
+
+    /** @brief Размер файла в момент обхода. */
+    uint64_t size = 0;
+};
+
+/**
+ * @brief Обходит дерево каталогов параллельно.
+ *
+ * Каждый каталог читается отдельной задачей пула потоков, которая ставит задачи
+ * для найденных подкаталогов, поэтому широкие и глубокие деревья читаются
+ * одновременно несколькими потоками. Символические ссылки пропускаются.
+ *
+ * @param directory Корень обхода.
+ * @param threads Число потоков (0 — по числу аппаратных потоков).
+ * @return Обычные файлы, упорядоченные по name.
+ * @throws std::runtime_error Если корень не является каталогом или каталог не удается прочитать.
+ */
+std::vector<TreeFile> walkTree(const std::string& directory, unsigned threads = 0);
+
+/**
+ * @class ArchiveWriter
+ * @brief Последовательно записывает члены контейнера и центральный каталог.
+ */
+class ArchiveWriter {
+private:
+    /** @brief Выходной файл контейнера. */
+    std::ofstream out;
+
+    /** @brief Накопленные записи каталога. */
+    std::vector<ArchiveEntry> entries;
+
+    /** @brief Имена добавленных членов. */
+    std::set<std::string> names;
+
+    /**
+     * @brief Проверяет имя нового члена и запоминает его.
+     * @param name Имя члена.
+     * @throws std::runtime_error Если контейнер завершен, имя повторяется, пусто или выходит за пределы каталога.
+     */
+    void reserveName(const std::string& name);
+
+    /** @brief Признак записанного каталога. */
+    bool finished = false;
+
+public:
+    /**
+     * @brief Создает контейнер и записывает его заголовок.
+     * @param archive_file Путь к создаваемому контейнеру.
+     * @throws std::runtime_error Если файл не удается создать.
+     */
+    explicit ArchiveWriter(const std::string& archive_file);
+
+    /**
+     * @brief Сжимает файл и добавляет его в контейнер.
+     * @param input_file Путь к добавляемому файлу.
+     * @param name Имя члена в контейнере.
+     * @param options Параметры сжатия.
+     * @throws std::runtime_error Если имя повторяется, пусто или выходит за пределы каталога, файл не удается прочитать или сжать.
+     */
+    void add(const std::string& input_file, const std::string& name, const CompressOptions& options = {});
+
+    /**
+     * @brief Добавляет все обычные файлы дерева каталогов с путями относительно его корня.
+     *
+     * Дерево обходится walkTree(), члены записываются по возрастанию имени. Файлы
+     * не больше options.block_size сжимаются пулом потоков в память задачами
+     * примерно по block_size байт (по 64 МиБ исходных данных за раунд) и
+     * записываются по порядку; большие файлы сжимаются по одному конвейером
+     * compressStream(), который сам распределяет блоки по потокам. Пустые каталоги
+     * не сохраняются.
+     *
+     * @param directory Корень дерева.
+     * @param options Параметры сжатия (threads задает число потоков).
+     * @throws std::runtime_error Если каталог не удается обойти, файл не удается прочитать или сжать.
+     */
+    void addTree(const std::string& directory, const CompressOptions& options = {});
+
+    /**
+     * @brief Записывает центральный каталог и хвост контейнера.
+     * @throws std::runtime_error Если запись не удалась.
+     */
+    void finish();
+
+    /**
+     * @brief Возвращает записи каталога, добавленные к этому моменту.
+     * @return Константная ссылка на записи каталога.
+     */
+    const std::vector<ArchiveEntry>& getEntries() const { return entries; }
+};
+
+/**
+ * @class ArchiveReader
+ * @brief Читает центральный каталог контейнера и извлекает отдельные члены.
+ */
+class ArchiveReader {
+private:
+    /** @brief Путь к контейнеру. */
+    std::string archive_file;
+
+    /** @brief Записи каталога в порядке хранения. */
+    std::vector<ArchiveEntry> entries;
+
+    /** @brief Индекс записей по имени. */
+    std::map<std::string, size_t> by_name;
+
+    /** @brief Словари для членов, сжатых со словарем. */
+    std::vector<std::shared_ptr<const Dictionary>> dictionaries;
+
+public:
+    /**
+     * @brief Открывает контейнер и читает его центральный каталог.
+     * @param archive_file Путь к контейнеру.
+     * @throws std::runtime_error Если файл не является контейнером или каталог поврежден.
+     */
+    explicit ArchiveReader(const std::string& archive_file);
+
+    /**
+     * @brief Проверяет, начинается ли файл с заголовка контейнера.
+     * @param path Путь к файлу.
+     * @return true, если файл является контейнером.
+     */
+    static bool isContainer(const std::string& path);
+
+    /**
+     * @brief Регистрирует словарь для распаковки членов, которые на него ссылаются.
+     * @param dictionary Загруженный словарь.
+     */
+    void addDictionary(std::shared_ptr<const Dictionary> dictionary) { dictionaries.push_back(std::move(dictionary)); }
+
+    /**
+     * @brief Возвращает записи центрального каталога.
+     * @return Константная ссылка на записи каталога.
+     */
+    const std::vector<ArchiveEntry>& getEntries() const { return entries; }
+
+    /**
+     * @brief Ищет член по имени.
+     * @param name Имя члена.
+     * @return Указатель на запись или nullptr, если члена нет.
+     */
+    const ArchiveEntry* find(const std::string& name) const;
+
+    /**
+     * @brief Распаковывает один член, переходя сразу к его данным.
+     *
+     * Права доступа и время изменения восстанавливаются из записи каталога.
+     * @param entry Запись каталога.
+     * @param output_file Путь к выходному файлу.
+     * @throws std::runtime_error Если архив члена поврежден или запись не удалась.
+     */
+    void extract(const ArchiveEntry& entry, const std::string& output_file) const;
+
+    /**
+     * @brief Распаковывает все члены, воссоздавая их относительные пути.
+     *
+     * Сначала создаются все нужные каталоги, затем члены распаковываются пулом
+     * потоков: маленькие члены объединяются в задачи примерно по 1 МиБ архива.
+     *
+     * @param directory Каталог, в который распаковываются члены.
+     * @param threads Число потоков (0 — по числу аппаратных потоков).
+     * @throws std::runtime_error Если какой-либо член не удается распаковать.
+     */
+    void extractAll(const std::string& directory, unsigned threads = 0) const;
+
+    /**
+     * @brief Проверяет контрольные суммы и размеры всех членов, ничего не распаковывая.
+     * @param threads Число рабочих потоков для проверки блоков (0 — по числу аппаратных потоков).
+     * @throws std::runtime_error Если какой-либо член поврежден; сообщение начинается с имени члена.
+     */
+    void verify(unsigned threads = 0) const;
+
+    /**
+     * @brief Распаковывает диапазон исходного содержимого члена.
+     * @param name Имя члена.
+     * @param offset Смещение начала диапазона в содержимом члена.
+     * @param length Длина диапазона; обрезается по концу содержимого.
+     * @param output_file Путь к выходному файлу.
+     * @return Число записанных байт.
+     * @throws std::runtime_error Если члена нет, он поврежден или диапазон начинается за концом содержимого.
+     */
+    uint64_t extractRange(const std::string& name, uint64_t offset, uint64_t length, const std::string& output_file) const;
+
+    /**
+     * @brief Распаковывает член по имени.
+     * @param name Имя члена.
+     * @param output_file Путь к выходному файлу.
+     * @throws std::runtime_error Если члена нет, архив члена поврежден или запись не удалась.
+     */
+    void extract(const std::string& name, const std::string& output_file) const;
+};
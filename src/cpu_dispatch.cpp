@@ -0,0 +1,61 @@
+#include "cpu_dispatch.h"
+#include <atomic>
+#include <stdexcept>
+
+namespace {
+
+std::atomic<KernelSet>& activeSet() {
+    static std::atomic<KernelSet> set(detectKernelSet());
+    return set;
+}
+
+}
+
+bool kernelSetSupported(KernelSet set) {
+#if defined(__GNUC__) && defined(__x86_64__)
+    __builtin_cpu_init();
+    switch (set) {
+    case KernelSet::Generic: return true;
+    case KernelSet::Sse42: return __builtin_cpu_supports("sse4.2");
+    case KernelSet::Avx2:
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+               __builtin_cpu_supports("bmi2");
+    }
+    return false;
+#else
+    return set == KernelSet::Generic;
+#endif
+}
+
+KernelSet detectKernelSet() {
+    for (KernelSet set : {KernelSet::Avx2, KernelSet::Sse42}) {
+        if (kernelSetSupported(set)) return set;
+    }
+    return KernelSet::Generic;
+}
+
+KernelSet activeKernelSet() {
+    return activeSet().load(std::memory_order_relaxed);
+}
+
+void setKernelSet(KernelSet set) {
+    if (!kernelSetSupported(set)) throw std::runtime_error(std::string("Kernel set is not supported by this CPU: ") + kernelSetName(set));
+    activeSet().store(set, std::memory_order_relaxed);
+}
+
+const char* kernelSetName(KernelSet set) {
+    switch (set) {
+    case KernelSet::Generic: return "generic";
+    case KernelSet::Sse42: return "sse4.2";
+    case KernelSet::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+KernelSet parseKernelSet(const std::string& name) {
+    if (name == "auto") return detectKernelSet();
+    for (KernelSet set : {KernelSet::Generic, KernelSet::Sse42, KernelSet::Avx2}) {
+        if (name == kernelSetName(set)) return set;
+    }
+    throw std::runtime_error("Unknown kernel set: " + name);
+}
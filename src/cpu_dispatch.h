@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+
+/**
+ * @file cpu_dispatch.h
+ * @brief Выбор набора горячих ядер (табличное декодирование, CRC32C) по возможностям процессора.
+ *
+ * Ядра собираются в нескольких вариантах под разные наборы инструкций x86-64
+ * (через атрибут target), а нужный вариант выбирается во время работы по CPUID.
+ * Это позволяет распространять один исполняемый файл для старых и новых процессоров.
+ * Все варианты дают побитово одинаковый результат.
+ */
+
+/**
+ * @brief Набор ядер; каждый следующий требует расширений предыдущего.
+ */
+enum class KernelSet {
+    /** @brief Базовый x86-64 (или не-x86 платформа): табличный CRC32C. */
+    Generic,
+
+    /** @brief Аппаратный CRC32C (SSE4.2), ядра кодека — базовые. */
+    Sse42,
+
+    /** @brief AVX2 и BMI2: табличный декодер со сдвигами shlx/shrx и без флаговых зависимостей. */
+    Avx2,
+};
+
+/**
+ * @brief Возвращает лучший набор ядер, поддерживаемый процессором.
+ * @return Набор ядер.
+ */
+KernelSet detectKernelSet();
+
+/**
+ * @brief Проверяет, может ли набор ядер выполняться на этом процессоре.
+ * @param set Набор ядер.
+ * @return true, если все нужные инструкции доступны.
+ */
+bool kernelSetSupported(KernelSet set);
+
+/**
+ * @brief Возвращает активный набор ядер (по умолчанию — detectKernelSet()).
+ * @return Набор ядер.
+ */
+KernelSet activeKernelSet();
+
+/**
+ * @brief Переключает активный набор ядер (для тестирования и сравнения вариантов).
+ *
+ * Переключение безопасно и во время работы других потоков: варианты ядер
+ * взаимозаменяемы.
+ *
+ * @param set Набор ядер.
+ * @throws std::runtime_error Если процессор не поддерживает набор.
+ */
+void setKernelSet(KernelSet set);
+
+/**
+ * @brief Возвращает имя набора ядер ("generic", "sse4.2", "avx2").
+ * @param set Набор ядер.
+ * @return Строка со статическим временем жизни.
+ */
+const char* kernelSetName(KernelSet set);
+
+/**
+ * @brief Разбирает имя набора ядер.
+ * @param name Имя из kernelSetName() или "auto" (лучший поддерживаемый набор).
+ * @return Набор ядер.
+ * @throws std::runtime_error Если имя неизвестно.
+ */
+KernelSet parseKernelSet(const std::string& name);
@@ -0,0 +1,76 @@
+#include "dictionary.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t kDictionaryMagic = 0x44465548; // "HUFD"
+
+uint32_t hashTable(const std::vector<unsigned char>& bytes) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char byte : bytes) {
+        hash = (hash ^ byte) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+}
+
+Dictionary Dictionary::train(const std::vector<std::string>& sample_files, uint32_t id) {
+    uint64_t counts[256] = {};
+    std::vector<char> buffer(1 << 16);
+    for (const auto& path : sample_files) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Failed to open sample file: " + path);
+        while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+            for (std::streamsize i = 0; i < in.gcount(); ++i) {
+                counts[static_cast<unsigned char>(buffer[i])]++;
+            }
+        }
+    }
+    return fromCounts(counts, id);
+}
+
+Dictionary Dictionary::fromCounts(const uint64_t* counts, uint32_t id) {
+    Dictionary dictionary;
+    for (int symbol = 0; symbol < 256; ++symbol) {
+        dictionary.table.freq[symbol] = counts[symbol] + 1;
+    }
+    dictionary.table.build();
+
+    std::vector<unsigned char> serialized(dictionary.table.frequencyTableSize());
+    dictionary.table.writeFrequencyTable(serialized.data());
+    dictionary.id = id ? id : hashTable(serialized);
+    return dictionary;
+}
+
+Dictionary Dictionary::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open dictionary file");
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 8 || frame::getU32(bytes.data()) != kDictionaryMagic) {
+        throw std::runtime_error("Unsupported dictionary format");
+    }
+
+    Dictionary dictionary;
+    dictionary.id = frame::getU32(bytes.data() + 4);
+    size_t used = dictionary.table.readFrequencyTable(bytes.data() + 8, bytes.size() - 8);
+    if (dictionary.id == 0 || used != bytes.size() - 8) throw std::runtime_error("Corrupted dictionary");
+    for (int symbol = 0; symbol < 256; ++symbol) {
+        if (dictionary.table.freq[symbol] == 0) throw std::runtime_error("Corrupted dictionary");
+    }
+    dictionary.table.build();
+    return dictionary;
+}
+
+void Dictionary::save(const std::string& path) const {
+    std::vector<unsigned char> bytes(8 + table.frequencyTableSize());
+    frame::putU32(bytes.data(), kDictionaryMagic);
+    frame::putU32(bytes.data() + 4, id);
+    table.writeFrequencyTable(bytes.data() + 8);
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    if (!out) throw std::runtime_error("Failed to write dictionary file");
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "block_codec.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file dictionary.h
+ * @brief Заранее обученные таблицы кодов («словари») для сжатия маленьких сообщений.
+ *
+ * Для сообщений в сотни байт таблица частот блока может быть больше самих данных.
+ * Словарь хранит таблицу частот, собранную по образцовому корпусу; архив ссылается
+ * на него по идентификатору, а блоки таблицу не содержат.
+ *
+ * Формат файла словаря: магическое число "HUFD", идентификатор (uint32),
+ * таблица частот в формате блока (uint32 число записей, затем пары символ/uint64 частота).
+ */
+
+/**
+ * @class Dictionary
+ * @brief Неизменяемый словарь: таблица частот по всем 256 символам с готовыми кодами.
+ *
+ * Коды и таблица декодирования строятся один раз при создании, после чего
+ * словарь используется только для чтения и может разделяться между потоками
+ * и миллионами вызовов.
+ */
+class Dictionary {
+private:
+    /** @brief Идентификатор словаря. */
+    uint32_t id = 0;
+
+    /** @brief Таблица частот с построенными кодами. */
+    CodeTable table;
+
+    Dictionary() = default;
+
+public:
+    /**
+     * @brief Обучает словарь на образцовых файлах.
+     *
+     * Частота каждого символа увеличивается на 1, поэтому словарем можно
+     * закодировать любые данные, а не только символы из корпуса.
+     *
+     * @param sample_files Пути к образцовым файлам.
+     * @param id Идентификатор словаря (0 — вычислить по содержимому).
+     * @return Обученный словарь.
+     * @throws std::runtime_error Если образец не удается прочитать.
+     */
+    static Dictionary train(const std::vector<std::string>& sample_files, uint32_t id = 0);
+
+    /**
+     * @brief Строит словарь по готовой гистограмме, как train() по прочитанному корпусу.
+     * @param counts Частоты 256 символов (к каждой прибавляется 1).
+     * @param id Идентификатор словаря (0 — вычислить по содержимому).
+     * @return Построенный словарь.
+     */
+    static Dictionary fromCounts(const uint64_t* counts, uint32_t id = 0);
+
+    /**
+     * @brief Загружает словарь из файла.
+     * @param path Путь к файлу словаря.
+     * @return Загруженный словарь.
+     * @throws std::runtime_error Если файл не удается прочитать или он поврежден.
+     */
+    static Dictionary load(const std::string& path);
+
+    /**
+     * @brief Сохраняет словарь в файл.
+     * @param path Путь к файлу словаря.
+     * @throws std::runtime_error Если запись не удалась.
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Возвращает идентификатор словаря.
+     * @return Идентификатор (не равен 0).
+     */
+    uint32_t getId() const { return id; }
+
+    /**
+     * @brief Возвращает таблицу словаря с построенными кодами.
+     * @return Константная ссылка на таблицу.
+     */
+    const CodeTable& getTable() const { return table; }
+};
@@ -1,126 +1,656 @@
 #include "huffman.h"
+#include "block_codec.h"
+#include "bounded_queue.h"
+#include "thread_pool.h"
+#include "dictionary.h"
+#include "huffman_context.h"
+#include "checksum.h"
+#include "wide_table.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
 #include <fstream>
-#include <queue>
 #include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HUFFMAN_POSIX_IO 1
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
-Node::Node(unsigned char s, uint64_t f) : symbol(s), freq(f), left(nullptr), right(nullptr) {}
-Node::Node(std::shared_ptr<Node> l, std::shared_ptr<Node> r) 
-    : symbol(0), freq(l->freq + r->freq), left(l), right(r) {}
+HuffmanArchiver::HuffmanArchiver() : context(std::make_unique<HuffmanContext>()) {}
+HuffmanArchiver::~HuffmanArchiver() = default;
 
-struct Compare {
-    bool operator()(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b) {
-        return a->freq > b->freq;
-    }
+namespace {
+
+struct PipelineBlock {
+    uint64_t seq = 0;
+    std::vector<unsigned char> raw;
+    size_t raw_size = 0;
+    std::vector<unsigned char> encoded;
 };
 
-void HuffmanArchiver::buildFrequencyTable(const std::string& input_file) {
-    std::ifstream in(input_file, std::ios::binary);
-    if (!in) throw std::runtime_error("Failed to open input file");
-    unsigned char byte;
-    while (in.read(reinterpret_cast<char*>(&byte), 1)) {
-        freq_table[byte]++;
+using BlockPtr = std::unique_ptr<PipelineBlock>;
+
+void writeArchiveHeader(std::ostream& out, const CompressOptions& options, uint64_t content_size) {
+    frame::Header file_header = frame::makeHeader(options, content_size);
+    unsigned char header[frame::kMaxHeaderSize];
+    frame::writeHeader(file_header, header);
+    out.write(reinterpret_cast<char*>(header), frame::headerSize(file_header.flags));
+}
+
+void writeEndMarker(std::ostream& out, uint32_t checksum) {
+    frame::BlockHeader header;
+    header.checksum = checksum;
+    unsigned char end_marker[frame::kBlockHeaderSize];
+    frame::writeBlockHeader(header, end_marker);
+    out.write(reinterpret_cast<char*>(end_marker), sizeof(end_marker));
+}
+
+uint32_t appendChecksum(uint32_t checksum, const std::vector<unsigned char>& encoded) {
+    for (size_t pos = 0; pos < encoded.size();) {
+        frame::BlockHeader header = frame::readBlockHeader(encoded.data() + pos);
+        checksum = crc32cCombine(checksum, header.checksum, header.raw_size);
+        pos += frame::kBlockHeaderSize + header.payload_size;
+    }
+    return checksum;
+}
+
+constexpr size_t kRunSize = 1 << 20;
+
+constexpr size_t kBatchTaskSize = 256 * 1024;
+
+// Заголовок архива, заголовок блока и признак конца с запасом на таблицу частот маленькой записи.
+constexpr size_t kBatchRecordOverhead = 128;
+
+size_t runSize(const CompressOptions& options) {
+    return options.block_size * std::max<size_t>(1, kRunSize / options.block_size);
+}
+
+size_t splitSegment(const CompressOptions& options) {
+    return options.adaptive_split ? options.split_segment : 0;
+}
+
+void encodeRun(BlockCodec& codec, const unsigned char* data, size_t size, std::vector<unsigned char>& out, const CompressOptions& options) {
+    codec.reset();
+    codec.setOptimalLengths(options.optimal_lengths);
+    codec.setWideSymbols(options.wide_symbols);
+    for (size_t offset = 0; offset < size; offset += options.block_size) {
+        codec.encode(data + offset, std::min(options.block_size, size - offset), out, options.dictionary.get(), splitSegment(options));
+    }
+}
+
+std::map<unsigned char, std::string> firstBlockCodes(const std::vector<unsigned char>& encoded, const CompressOptions& options) {
+    frame::BlockHeader header = frame::readBlockHeader(encoded.data());
+    if (header.mode != frame::BlockMode::Huffman) return {};
+    CodeTable table;
+    table.optimal_lengths = options.optimal_lengths;
+    table.readFrequencyTable(encoded.data() + frame::kBlockHeaderSize, header.payload_size);
+    table.build();
+    return table.toCodeMap();
+}
+
+void addFrequencies(uint64_t* totals, const frame::BlockHeader& block, const BlockCodec& codec, const unsigned char* raw) {
+    if (block.mode == frame::BlockMode::Huffman) {
+        for (int s = 0; s < 256; ++s) totals[s] += codec.getTable().freq[s];
+    } else {
+        countHistogram(raw, block.raw_size, totals);
     }
 }
 
-void HuffmanArchiver::buildHuffmanTree() {
-    std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, Compare> pq;
-    for (const auto& pair : freq_table) {
-        pq.push(std::make_shared<Node>(pair.first, pair.second));
+class SeekIndex {
+private:
+    bool enabled;
+    std::vector<frame::IndexEntry> entries;
+    frame::IndexEntry next;
+
+public:
+    SeekIndex(const CompressOptions& options, uint64_t content_size) : enabled(options.seek_index) {
+        next.block_offset = frame::headerSize(frame::makeHeader(options, content_size).flags);
     }
-    while (pq.size() > 1) {
-        auto left = pq.top(); pq.pop();
-        auto right = pq.top(); pq.pop();
-        pq.push(std::make_shared<Node>(left, right));
+
+    void add(const std::vector<unsigned char>& encoded) {
+        if (!enabled) return;
+        for (size_t pos = 0; pos < encoded.size();) {
+            frame::BlockHeader header = frame::readBlockHeader(encoded.data() + pos);
+            entries.push_back(next);
+            next.block_offset += frame::kBlockHeaderSize + header.payload_size;
+            next.raw_offset += header.raw_size;
+            pos += frame::kBlockHeaderSize + header.payload_size;
+        }
+    }
+
+    void write(std::ostream& out) const {
+        if (!enabled) return;
+        std::vector<unsigned char> bytes(frame::indexSize(entries.size()));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            frame::writeIndexEntry(entries[i], bytes.data() + i * frame::kIndexEntrySize);
+        }
+        frame::writeIndexFooter(static_cast<uint32_t>(entries.size()), bytes.data() + entries.size() * frame::kIndexEntrySize);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
     }
-    root = pq.empty() ? nullptr : pq.top();
+};
+
+uint64_t streamSize(std::istream& in) {
+    std::streampos start = in.tellg();
+    if (start == std::streampos(-1)) return 0;
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.clear();
+    in.seekg(start);
+    if (!in || end == std::streampos(-1) || end < start) return 0;
+    return static_cast<uint64_t>(end - start);
 }
 
-void HuffmanArchiver::buildHuffmanCodes(const std::shared_ptr<Node>& node, const std::string& code) {
-    if (!node) return;
-    if (!node->left && !node->right) {
-        huffman_codes[node->symbol] = code.empty() ? "0" : code;
+frame::Header readArchiveHeader(std::istream& in) {
+    unsigned char header[frame::kMaxHeaderSize];
+    if (!in.read(reinterpret_cast<char*>(header), frame::kHeaderSize)) {
+        throw std::runtime_error("Archive is empty or corrupted");
+    }
+    frame::Header file_header = frame::readHeader(header);
+    size_t extension = frame::headerSize(file_header.flags) - frame::kHeaderSize;
+    if (!in.read(reinterpret_cast<char*>(header + frame::kHeaderSize), extension)) {
+        throw std::runtime_error("Archive is empty or corrupted");
     }
-    buildHuffmanCodes(node->left, code + "0");
-    buildHuffmanCodes(node->right, code + "1");
+    frame::readHeaderExtension(file_header, header + frame::kHeaderSize);
+    return file_header;
 }
 
-void HuffmanArchiver::writeFrequencyTable(std::ofstream& out) {
-    uint32_t size = freq_table.size();
-    out.write(reinterpret_cast<char*>(&size), sizeof(size));
-    for (const auto& pair : freq_table) {
-        out.write(reinterpret_cast<const char*>(&pair.first), 1);
-        uint64_t freq = pair.second;
-        out.write(reinterpret_cast<char*>(&freq), sizeof(freq));
+class BlockOutput {
+public:
+    virtual ~BlockOutput() = default;
+    virtual unsigned char* reserve(size_t size) = 0;
+    virtual void commit(size_t size) = 0;
+};
+
+class StreamOutput : public BlockOutput {
+private:
+    std::ostream& out;
+    std::vector<unsigned char>& buffer;
+
+public:
+    StreamOutput(std::ostream& out, std::vector<unsigned char>& buffer) : out(out), buffer(buffer) {}
+
+    unsigned char* reserve(size_t size) override {
+        if (buffer.size() < size) buffer.resize(size);
+        return buffer.data();
+    }
+
+    void commit(size_t size) override {
+        out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(size));
+        if (!out) throw std::runtime_error("Failed to write output file");
+    }
+};
+
+#ifdef HUFFMAN_POSIX_IO
+constexpr size_t kOutputBufferSize = 8 << 20;
+
+// Файл заранее занимает место под все содержимое, а блоки декодируются прямо в
+// большой буфер, который сбрасывается на диск одним pwrite.
+class FileOutput : public BlockOutput {
+private:
+    int fd;
+    std::vector<unsigned char>& buffer;
+    size_t fill = 0;
+    uint64_t offset = 0;
+
+    void flush() {
+        for (size_t done = 0; done < fill;) {
+            ssize_t n = ::pwrite(fd, buffer.data() + done, fill - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("Failed to write output file");
+            done += static_cast<size_t>(n);
+        }
+        offset += fill;
+        fill = 0;
+    }
+
+public:
+    FileOutput(const std::string& path, uint64_t size, std::vector<unsigned char>& buffer) : buffer(buffer) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::runtime_error("Error opening files");
+#ifdef __linux__
+        int rc = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+#else
+        int rc = EOPNOTSUPP;
+#endif
+        if (rc == ENOSPC || rc == EFBIG || (rc != 0 && ::ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+            ::close(fd);
+            throw std::runtime_error("Failed to write output file");
+        }
+        buffer.resize(static_cast<size_t>(std::min<uint64_t>(size, kOutputBufferSize)));
+    }
+
+    ~FileOutput() override {
+        if (fd < 0) return;
+        // Распаковка прервалась: хвост, зарезервированный под содержимое, не должен остаться в файле.
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {}
+        ::close(fd);
+    }
+
+    unsigned char* reserve(size_t size) override {
+        if (buffer.size() - fill < size) {
+            flush();
+            if (buffer.size() < size) buffer.resize(size);
+        }
+        return buffer.data() + fill;
+    }
+
+    void commit(size_t size) override { fill += size; }
+
+    void finish() {
+        flush();
+        int rc = ::close(fd);
+        fd = -1;
+        if (rc != 0) throw std::runtime_error("Failed to write output file");
+    }
+};
+#endif
+
+void decodeBlocks(std::istream& in, const frame::Header& file_header, BlockCodec& codec, const Dictionary* dictionary,
+                  std::vector<unsigned char>& payload_buffer, BlockOutput& output, uint64_t* totals) {
+    codec.reset();
+    codec.setOptimalLengths(file_header.flags & frame::kFlagOptimalLengths);
+    bool sized = file_header.flags & frame::kFlagContentSize;
+    uint64_t written = 0;
+    uint32_t checksum = 0;
+    for (uint64_t blocks = 0;; ++blocks) {
+        frame::BlockHeader block;
+        if (frame::implicitEnd(file_header, blocks)) {
+            block.checksum = checksum;
+        } else {
+            unsigned char block_header[frame::kBlockHeaderSize];
+            if (!in.read(reinterpret_cast<char*>(block_header), sizeof(block_header))) {
+                throw std::runtime_error("Corrupted archive: missing end of archive marker");
+            }
+            block = frame::readBlockHeader(block_header);
+        }
+        if (block.raw_size == 0) {
+            if (block.checksum != checksum) throw std::runtime_error("Corrupted archive: content checksum mismatch");
+            if (sized && written != file_header.content_size) throw std::runtime_error("Corrupted archive: content size mismatch");
+            return;
+        }
+        frame::checkBlockHeader(block, file_header);
+        if (sized && block.raw_size > file_header.content_size - written) throw std::runtime_error("Corrupted archive: content size mismatch");
+
+        payload_buffer.resize(block.payload_size);
+        if (!in.read(reinterpret_cast<char*>(payload_buffer.data()), block.payload_size)) {
+            throw std::runtime_error("Corrupted block: unexpected end of data");
+        }
+        unsigned char* raw = output.reserve(block.raw_size);
+        codec.decode(block, payload_buffer.data(), raw, dictionary);
+        addFrequencies(totals, block, codec, raw);
+        checksum = crc32cCombine(checksum, block.checksum, block.raw_size);
+        output.commit(block.raw_size);
+        written += block.raw_size;
     }
 }
 
-void HuffmanArchiver::readFrequencyTable(std::ifstream& in) {
-    uint32_t size;
-    in.read(reinterpret_cast<char*>(&size), sizeof(size));
-    if (!in) throw std::runtime_error("Failed to read frequency table size");
-    for (uint32_t i = 0; i < size; ++i) {
-        unsigned char symbol;
-        uint64_t freq;
-        in.read(reinterpret_cast<char*>(&symbol), 1);
-        if (!in) throw std::runtime_error("Corrupted frequency table: failed to read symbol");
-        in.read(reinterpret_cast<char*>(&freq), sizeof(freq));
-        if (!in) throw std::runtime_error("Corrupted frequency table: failed to read frequency");
-        freq_table[symbol] = freq;
+void fillFrequencyTable(std::map<unsigned char, uint64_t>& freq_table, const uint64_t* totals) {
+    for (int s = 0; s < 256; ++s) {
+        if (totals[s]) freq_table[static_cast<unsigned char>(s)] = totals[s];
     }
 }
 
-void HuffmanArchiver::compress(const std::string& input_file, const std::string& output_file) {
-    freq_table.clear();
-    huffman_codes.clear();
-    buildFrequencyTable(input_file);
-    if (freq_table.empty()) throw std::runtime_error("Input file is empty");
-    buildHuffmanTree();
-    buildHuffmanCodes(root, "");
+struct VerifyBlock {
+    frame::BlockHeader header;
+    std::vector<unsigned char> payload;
+    std::vector<unsigned char> table;
+};
+
+using VerifyBlockPtr = std::unique_ptr<VerifyBlock>;
+
+struct WorkerState {
+    BlockCodec codec;
+    std::vector<unsigned char> raw;
+    std::vector<unsigned char> encoded;
+};
+
+// Большой файл кодируется прогонами в окне из slots.size() буферов: прогон seq занимает слот
+// seq % slots.size() и ставится в пул, только когда прогон seq - slots.size() уже записан.
+struct LargeFileJob {
+    std::string path;
+    uint64_t size = 0;
+    size_t count = 0;
+    std::vector<std::vector<unsigned char>> slots;
+    std::vector<bool> ready;
+    std::mutex mutex;
+    size_t next_write = 0;
+    size_t next_submit = 0;
+    std::atomic<bool> failed{false};
+    std::ofstream out;
+    uint32_t checksum = 0;
+    SeekIndex index;
+
+    LargeFileJob(const CompressOptions& options, uint64_t size) : size(size), index(options, size) {}
+};
 
+}
+
+CompressOptions CompressOptions::fromLevel(int level) {
+    static const size_t kSegments[] = {256 * 1024, 64 * 1024, 32 * 1024, 16 * 1024, 8 * 1024, 8 * 1024, 4 * 1024};
+    if (level < 1 || level > 9) throw std::runtime_error("Invalid compression level");
+    CompressOptions options;
+    if (level == 1) options.block_size = 4 << 20;
+    options.adaptive_split = level >= 3;
+    if (options.adaptive_split) options.split_segment = kSegments[level - 3];
+    options.optimal_lengths = level >= 8;
+    return options;
+}
+
+void HuffmanArchiver::compress(const std::string& input_file, const std::string& output_file, const CompressOptions& options) {
     std::ifstream in(input_file, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open input file");
+    if (in.peek() == std::ifstream::traits_type::eof()) throw std::runtime_error("Input file is empty");
+    if (options.block_size == 0 || options.block_size > frame::kMaxBlockSize) throw std::runtime_error("Invalid block size");
+
     std::ofstream out(output_file, std::ios::binary);
-    if (!in || !out) throw std::runtime_error("Error opening files");
-
-    writeFrequencyTable(out);
-
-    std::string buffer;
-    unsigned char byte;
-    while (in.read(reinterpret_cast<char*>(&byte), 1)) {
-        buffer += huffman_codes[byte];
-        while (buffer.size() >= 8) {
-            unsigned char out_byte = 0;
-            for (int i = 0; i < 8; ++i) {
-                out_byte |= (buffer[i] == '1' ? 1 : 0) << (7 - i);
+    if (!out) throw std::runtime_error("Error opening files");
+    compressStream(in, out, options);
+}
+
+void HuffmanArchiver::compressStream(std::istream& in, std::ostream& out, const CompressOptions& options) {
+    freq_table.clear();
+    huffman_codes.clear();
+    if (in.peek() == std::istream::traits_type::eof()) throw std::runtime_error("Input file is empty");
+    if (options.block_size == 0 || options.block_size > frame::kMaxBlockSize) throw std::runtime_error("Invalid block size");
+
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    size_t in_flight = threads * 2;
+    size_t run_size = runSize(options);
+    uint64_t content_size = streamSize(in);
+
+    BoundedQueue<BlockPtr> free_blocks(in_flight);
+    BoundedQueue<BlockPtr> encode_queue(in_flight);
+    BoundedQueue<BlockPtr> write_queue(in_flight);
+    for (size_t i = 0; i < in_flight; ++i) {
+        free_blocks.push(std::make_unique<PipelineBlock>());
+    }
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = e;
+        }
+        free_blocks.close();
+        encode_queue.close();
+        write_queue.close();
+    };
+
+    std::thread reader([&] {
+        try {
+            uint64_t remaining = content_size ? content_size : UINT64_MAX;
+            for (uint64_t seq = 0; remaining > 0; ++seq) {
+                BlockPtr block;
+                if (!free_blocks.pop(block)) break;
+                block->raw.resize(run_size);
+                in.read(reinterpret_cast<char*>(block->raw.data()), static_cast<std::streamsize>(std::min<uint64_t>(run_size, remaining)));
+                block->raw_size = static_cast<size_t>(in.gcount());
+                if (in.bad()) throw std::runtime_error("Failed to read input file");
+                if (block->raw_size == 0) break;
+                remaining -= block->raw_size;
+                block->seq = seq;
+                if (!encode_queue.push(std::move(block))) break;
             }
-            out.write(reinterpret_cast<char*>(&out_byte), 1);
-            buffer.erase(0, 8);
+            if (content_size && remaining != 0) throw std::runtime_error("Input file changed during compression");
+            encode_queue.close();
+        } catch (...) {
+            fail(std::current_exception());
         }
+    });
+
+    std::atomic<unsigned> active_workers(threads);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([&] {
+            try {
+                BlockCodec codec;
+                BlockPtr block;
+                while (encode_queue.pop(block)) {
+                    block->encoded.clear();
+                    encodeRun(codec, block->raw.data(), block->raw_size, block->encoded, options);
+                    if (block->seq == 0) huffman_codes = firstBlockCodes(block->encoded, options);
+                    if (!write_queue.push(std::move(block))) break;
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+            if (--active_workers == 0) write_queue.close();
+        });
     }
-    if (!buffer.empty()) {
-        unsigned char out_byte = 0;
-        for (size_t i = 0; i < buffer.size(); ++i) {
-            out_byte |= (buffer[i] == '1' ? 1 : 0) << (7 - i);
+
+    try {
+        writeArchiveHeader(out, options, content_size);
+
+        // В обработке не больше in_flight блоков, поэтому блок seq ждет своей очереди в слоте seq % in_flight.
+        std::vector<BlockPtr> reorder(in_flight);
+        uint64_t next_seq = 0;
+        uint32_t checksum = 0;
+        SeekIndex index(options, content_size);
+        BlockPtr block;
+        while (write_queue.pop(block)) {
+            reorder[block->seq % in_flight] = std::move(block);
+            for (; reorder[next_seq % in_flight]; ++next_seq) {
+                BlockPtr ready = std::move(reorder[next_seq % in_flight]);
+                out.write(reinterpret_cast<const char*>(ready->encoded.data()), ready->encoded.size());
+                if (!out) throw std::runtime_error("Failed to write output file");
+                checksum = appendChecksum(checksum, ready->encoded);
+                index.add(ready->encoded);
+                free_blocks.push(std::move(ready));
+            }
         }
-        out.write(reinterpret_cast<char*>(&out_byte), 1);
-        unsigned char padding = 8 - buffer.size();
-        out.write(reinterpret_cast<char*>(&padding), 1);
-    } else {
-        unsigned char padding = 0;
-        out.write(reinterpret_cast<char*>(&padding), 1);
+
+        // fail() закрывает очередь записи, и выше дописываются уже готовые блоки. Признак конца
+        // с CRC32C частичного содержимого сделал бы обрезанный архив корректным, поэтому при
+        // ошибке вывод остается без него.
+        bool failed;
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            failed = error != nullptr;
+        }
+        if (!failed) {
+            writeEndMarker(out, checksum);
+            index.write(out);
+            if (!out) throw std::runtime_error("Failed to write output file");
+        }
+    } catch (...) {
+        fail(std::current_exception());
     }
+
+    reader.join();
+    for (auto& worker : workers) worker.join();
+    if (error) std::rethrow_exception(error);
+}
+
+std::vector<FileError> HuffmanArchiver::compressMany(const std::vector<std::string>& input_files, const CompressOptions& options) {
+    if (options.block_size == 0 || options.block_size > frame::kMaxBlockSize) throw std::runtime_error("Invalid block size");
+
+    std::vector<FileError> errors;
+    std::mutex errors_mutex;
+    auto report = [&](const std::string& path, const std::string& message) {
+        std::lock_guard<std::mutex> lock(errors_mutex);
+        errors.push_back({path, message});
+    };
+
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    std::vector<WorkerState> states(threads);
+    std::vector<std::unique_ptr<LargeFileJob>> jobs;
+
+    auto readBlock = [&](WorkerState& state, const std::string& path, uint64_t offset, size_t size) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Failed to open input file");
+        in.seekg(static_cast<std::streamoff>(offset));
+        state.raw.resize(size);
+        if (!in.read(reinterpret_cast<char*>(state.raw.data()), size)) {
+            throw std::runtime_error("Failed to read input file");
+        }
+    };
+
+    auto compressSmall = [&](WorkerState& state, const std::string& path, size_t size) {
+        try {
+            readBlock(state, path, 0, size);
+            state.encoded.clear();
+            encodeRun(state.codec, state.raw.data(), size, state.encoded, options);
+            std::ofstream out(path + ".huff", std::ios::binary);
+            if (!out) throw std::runtime_error("Error opening files");
+            writeArchiveHeader(out, options, size);
+            out.write(reinterpret_cast<const char*>(state.encoded.data()), state.encoded.size());
+            writeEndMarker(out, appendChecksum(0, state.encoded));
+            SeekIndex index(options, size);
+            index.add(state.encoded);
+            index.write(out);
+            if (!out) throw std::runtime_error("Failed to write output file");
+        } catch (const std::exception& e) {
+            report(path, e.what());
+        }
+    };
+
+    WorkStealingPool pool(threads);
+    const size_t run_size = runSize(options);
+
+    auto failJob = [&](LargeFileJob& job, const std::string& message) {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (job.failed.exchange(true)) return;
+        report(job.path, message);
+        if (job.out.is_open()) {
+            job.out.close();
+            std::error_code ec;
+            fs::remove(job.path + ".huff", ec);
+        }
+    };
+
+    // Вызывается под job.mutex: дописывает готовые прогоны по порядку и ставит в пул следующие.
+    std::function<void(LargeFileJob*, size_t)> submitRun;
+    auto writeReadyRuns = [&](LargeFileJob& job) {
+        const size_t window = job.slots.size();
+        for (; job.next_write < job.count && job.ready[job.next_write % window]; ++job.next_write) {
+            std::vector<unsigned char>& encoded = job.slots[job.next_write % window];
+            if (job.next_write == 0) {
+                job.out.open(job.path + ".huff", std::ios::binary);
+                if (!job.out) throw std::runtime_error("Error opening files");
+                writeArchiveHeader(job.out, options, job.size);
+            }
+            job.out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+            if (!job.out) throw std::runtime_error("Failed to write output file");
+            job.checksum = appendChecksum(job.checksum, encoded);
+            job.index.add(encoded);
+            job.ready[job.next_write % window] = false;
+            if (job.next_submit < job.count) submitRun(&job, job.next_submit++);
+        }
+        if (job.next_write < job.count) return;
+        writeEndMarker(job.out, job.checksum);
+        job.index.write(job.out);
+        job.out.close();
+        if (!job.out) throw std::runtime_error("Failed to write output file");
+        std::vector<std::vector<unsigned char>>().swap(job.slots);
+    };
+
+    submitRun = [&](LargeFileJob* job, size_t seq) {
+        pool.submit([&, job, seq](unsigned worker) {
+            WorkerState& state = states[worker];
+            try {
+                if (job->failed) return;
+                uint64_t offset = static_cast<uint64_t>(seq) * run_size;
+                size_t length = static_cast<size_t>(std::min<uint64_t>(run_size, job->size - offset));
+                readBlock(state, job->path, offset, length);
+                std::vector<unsigned char>& encoded = job->slots[seq % job->slots.size()];
+                encoded.clear();
+                encodeRun(state.codec, state.raw.data(), length, encoded, options);
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (job->failed) return;
+                job->ready[seq % job->slots.size()] = true;
+                writeReadyRuns(*job);
+            } catch (const std::exception& e) {
+                failJob(*job, e.what());
+            }
+        });
+    };
+
+    std::vector<std::pair<std::string, size_t>> batch;
+    size_t batch_bytes = 0;
+    auto flushBatch = [&] {
+        if (batch.empty()) return;
+        pool.submit([&, files = std::move(batch)](unsigned worker) {
+            for (const auto& file : files) compressSmall(states[worker], file.first, file.second);
+        });
+        batch.clear();
+        batch_bytes = 0;
+    };
+
+    for (const auto& path : input_files) {
+        std::error_code ec;
+        uint64_t size = fs::file_size(path, ec);
+        if (ec) {
+            report(path, "Failed to open input file");
+            continue;
+        }
+        if (size == 0) {
+            report(path, "Input file is empty");
+            continue;
+        }
+        if (size <= options.block_size) {
+            batch.emplace_back(path, static_cast<size_t>(size));
+            batch_bytes += size;
+            if (batch_bytes >= options.block_size) flushBatch();
+            continue;
+        }
+
+        jobs.push_back(std::make_unique<LargeFileJob>(options, size));
+        LargeFileJob* job = jobs.back().get();
+        job->path = path;
+        job->count = static_cast<size_t>((size + run_size - 1) / run_size);
+        job->slots.resize(std::min<size_t>(threads, job->count));
+        job->ready.resize(job->slots.size());
+        for (; job->next_submit < job->slots.size(); ++job->next_submit) submitRun(job, job->next_submit);
+    }
+    flushBatch();
+    pool.wait();
+    return errors;
 }
 
 void HuffmanArchiver::decompress(const std::string& input_file, const std::string& output_file, bool write_freq) {
-    freq_table.clear();
     std::ifstream in(input_file, std::ios::binary);
-    std::ofstream out(output_file, std::ios::binary);
-    if (!in || !out) throw std::runtime_error("Error opening files");
+    if (!in) throw std::runtime_error("Error opening files");
+    freq_table.clear();
+    frame::Header file_header = readArchiveHeader(in);
+    BlockCodec& codec = context->getCodec();
+    const Dictionary* dictionary = context->findDictionary(file_header);
 
-    readFrequencyTable(in);
-    if (freq_table.empty()) throw std::runtime_error("Archive is empty or corrupted");
-    buildHuffmanTree();
+    uint64_t totals[256] = {};
+#ifdef HUFFMAN_POSIX_IO
+    if (file_header.flags & frame::kFlagContentSize) {
+        std::error_code ec;
+        // Каждый блок занимает не меньше заголовка и байта нагрузки, а block_size ограничен kMaxBlockSize.
+        uint64_t blocks = fs::file_size(input_file, ec) / (frame::kBlockHeaderSize + 1);
+        uint64_t needed = file_header.content_size / file_header.block_size + (file_header.content_size % file_header.block_size != 0);
+        if (ec || needed > blocks) {
+            throw std::runtime_error("Corrupted archive: content size mismatch");
+        }
+        FileOutput out(output_file, file_header.content_size, raw_buffer);
+        decodeBlocks(in, file_header, codec, dictionary, payload_buffer, out, totals);
+        out.finish();
+    } else
+#endif
+    {
+        std::ofstream out(output_file, std::ios::binary);
+        if (!out) throw std::runtime_error("Error opening files");
+        StreamOutput sink(out, raw_buffer);
+        decodeBlocks(in, file_header, codec, dictionary, payload_buffer, sink, totals);
+    }
+    fillFrequencyTable(freq_table, totals);
 
     if (write_freq) {
         std::ofstream freq_out(fs::path(output_file).stem().string() + "_freq.txt");
@@ -129,29 +659,349 @@ void HuffmanArchiver::decompress(const std::string& input_file, const std::strin
             freq_out << "Symbol: " << symbol << ", Frequency: " << pair.second << "\n";
         }
     }
+}
 
-    unsigned char padding;
-    in.seekg(-1, std::ios::end);
-    in.read(reinterpret_cast<char*>(&padding), 1);
-    in.seekg(freq_table.size() * 9 + 4, std::ios::beg);
+void HuffmanArchiver::decompressStream(std::istream& in, std::ostream& out) {
+    freq_table.clear();
+    frame::Header file_header = readArchiveHeader(in);
+    uint64_t totals[256] = {};
+    StreamOutput sink(out, raw_buffer);
+    decodeBlocks(in, file_header, context->getCodec(), context->findDictionary(file_header), payload_buffer, sink, totals);
+    fillFrequencyTable(freq_table, totals);
+}
 
-    std::shared_ptr<Node> current = root;
-    unsigned char byte;
-    std::streampos file_size = fs::file_size(input_file);
-    std::streampos data_start = freq_table.size() * 9 + 4;
-    std::streampos data_end = file_size - std::streamoff(1);
-    uint64_t total_bits = (data_end - data_start) * 8 - padding;
-    uint64_t processed_bits = 0;
+uint64_t HuffmanArchiver::verify(const std::string& input_file, unsigned threads) {
+    std::ifstream in(input_file, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open input file");
+    return verifyStream(in, threads);
+}
 
-    while (in.read(reinterpret_cast<char*>(&byte), 1) && in.tellg() <= data_end) {
-        for (int i = 7; i >= 0 && processed_bits < total_bits; --i) {
-            bool bit = (byte >> i) & 1;
-            current = bit ? current->right : current->left;
-            if (!current->left && !current->right) {
-                out.write(reinterpret_cast<char*>(&current->symbol), 1);
-                current = root;
+uint64_t HuffmanArchiver::verifyStream(std::istream& in, unsigned threads) {
+    frame::Header file_header = readArchiveHeader(in);
+    const Dictionary* dictionary = context->findDictionary(file_header);
+
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    size_t in_flight = threads * 2;
+
+    BoundedQueue<VerifyBlockPtr> free_blocks(in_flight);
+    BoundedQueue<VerifyBlockPtr> verify_queue(in_flight);
+    for (size_t i = 0; i < in_flight; ++i) {
+        free_blocks.push(std::make_unique<VerifyBlock>());
+    }
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = e;
+        }
+        free_blocks.close();
+        verify_queue.close();
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([&] {
+            try {
+                BlockCodec codec;
+                std::vector<unsigned char> raw;
+                VerifyBlockPtr block;
+                while (verify_queue.pop(block)) {
+                    raw.resize(block->header.raw_size);
+                    codec.reset();
+                    codec.setOptimalLengths(file_header.flags & frame::kFlagOptimalLengths);
+                    if (block->header.mode == frame::BlockMode::Repeat) codec.loadTable(block->table.data(), block->table.size());
+                    codec.decode(block->header, block->payload.data(), raw.data(), dictionary);
+                    if (!free_blocks.push(std::move(block))) break;
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        });
+    }
+
+    uint64_t content_size = 0;
+    try {
+        uint32_t checksum = 0;
+        std::vector<unsigned char> last_table;
+        for (uint64_t blocks = 0;; ++blocks) {
+            frame::BlockHeader header;
+            if (frame::implicitEnd(file_header, blocks)) {
+                header.checksum = checksum;
+            } else {
+                unsigned char block_header[frame::kBlockHeaderSize];
+                if (!in.read(reinterpret_cast<char*>(block_header), sizeof(block_header))) {
+                    throw std::runtime_error("Corrupted archive: missing end of archive marker");
+                }
+                header = frame::readBlockHeader(block_header);
             }
-            processed_bits++;
+            if (header.raw_size == 0) {
+                if (header.checksum != checksum) throw std::runtime_error("Corrupted archive: content checksum mismatch");
+                if ((file_header.flags & frame::kFlagContentSize) && content_size != file_header.content_size) {
+                    throw std::runtime_error("Corrupted archive: content size mismatch");
+                }
+                break;
+            }
+            frame::checkBlockHeader(header, file_header);
+
+            VerifyBlockPtr block;
+            if (!free_blocks.pop(block)) break;
+            block->header = header;
+            block->payload.resize(header.payload_size);
+            if (!in.read(reinterpret_cast<char*>(block->payload.data()), header.payload_size)) {
+                throw std::runtime_error("Corrupted block: unexpected end of data");
+            }
+            if (header.mode == frame::BlockMode::Huffman) {
+                size_t table_size = header.payload_size < 4 ? 0 : 4 + uint64_t(frame::getU32(block->payload.data())) * 9;
+                last_table.assign(block->payload.begin(), block->payload.begin() + std::min<size_t>(table_size, header.payload_size));
+            } else if (header.mode == frame::BlockMode::Repeat) {
+                if (last_table.empty()) throw std::runtime_error("Corrupted block: no table to reuse");
+                block->table = last_table;
+            }
+            checksum = crc32cCombine(checksum, header.checksum, header.raw_size);
+            content_size += header.raw_size;
+            if (!verify_queue.push(std::move(block))) break;
         }
+        verify_queue.close();
+    } catch (...) {
+        fail(std::current_exception());
     }
-}
\ No newline at end of file
+
+    for (auto& worker : workers) worker.join();
+    if (error) std::rethrow_exception(error);
+    return content_size;
+}
+
+uint64_t HuffmanArchiver::extractRange(const std::string& input_file, uint64_t offset, uint64_t length, const std::string& output_file) {
+    std::ifstream in(input_file, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open input file");
+    uint64_t archive_size = fs::file_size(input_file);
+    std::ofstream out(output_file, std::ios::binary);
+    if (!out) throw std::runtime_error("Error opening files");
+    return extractRangeStream(in, archive_size, offset, length, out);
+}
+
+uint64_t HuffmanArchiver::extractRangeStream(std::istream& in, uint64_t archive_size, uint64_t offset, uint64_t length, std::ostream& out) {
+    std::streamoff base = in.tellg();
+    frame::Header file_header = readArchiveHeader(in);
+    const Dictionary* dictionary = context->findDictionary(file_header);
+    BlockCodec& codec = context->getCodec();
+    codec.reset();
+    codec.setOptimalLengths(file_header.flags & frame::kFlagOptimalLengths);
+
+    auto readBlockHeaderAt = [&](uint64_t block_offset) {
+        unsigned char block_header[frame::kBlockHeaderSize];
+        in.seekg(base + static_cast<std::streamoff>(block_offset));
+        if (!in.read(reinterpret_cast<char*>(block_header), sizeof(block_header))) {
+            throw std::runtime_error("Corrupted archive: invalid block index");
+        }
+        frame::BlockHeader block = frame::readBlockHeader(block_header);
+        if (block.raw_size != 0) frame::checkBlockHeader(block, file_header);
+        return block;
+    };
+
+    frame::IndexEntry start;
+    start.block_offset = frame::headerSize(file_header.flags);
+    std::vector<frame::IndexEntry> index;
+    size_t start_index = 0;
+    if ((file_header.flags & frame::kFlagIndex) && archive_size >= start.block_offset + frame::kIndexFooterSize) {
+        unsigned char footer[frame::kIndexFooterSize];
+        in.seekg(base + static_cast<std::streamoff>(archive_size - frame::kIndexFooterSize));
+        if (!in.read(reinterpret_cast<char*>(footer), sizeof(footer))) throw std::runtime_error("Corrupted archive: missing block index");
+        uint64_t count = frame::readIndexFooter(footer);
+        if (frame::indexSize(count) > archive_size - start.block_offset) throw std::runtime_error("Corrupted archive: invalid block index");
+
+        payload_buffer.resize(count * frame::kIndexEntrySize);
+        in.seekg(base + static_cast<std::streamoff>(archive_size - frame::indexSize(count)));
+        if (!in.read(reinterpret_cast<char*>(payload_buffer.data()), payload_buffer.size())) {
+            throw std::runtime_error("Corrupted archive: missing block index");
+        }
+        index.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            index[i] = frame::readIndexEntry(payload_buffer.data() + i * frame::kIndexEntrySize);
+            if (index[i].block_offset < start.block_offset || index[i].block_offset >= archive_size) {
+                throw std::runtime_error("Corrupted archive: invalid block index");
+            }
+        }
+        auto it = std::upper_bound(index.begin(), index.end(), offset, [](uint64_t value, const frame::IndexEntry& entry) {
+            return value < entry.raw_offset;
+        });
+        if (it != index.begin()) {
+            start_index = static_cast<size_t>(it - index.begin()) - 1;
+            start = index[start_index];
+        }
+    } else if (file_header.flags & frame::kFlagIndex) {
+        throw std::runtime_error("Corrupted archive: missing block index");
+    }
+
+    in.clear();
+    in.seekg(base + static_cast<std::streamoff>(start.block_offset));
+    uint64_t end = length > UINT64_MAX - offset ? UINT64_MAX : offset + length;
+    uint64_t raw_offset = start.raw_offset;
+    uint64_t block_offset = start.block_offset;
+    uint64_t table_offset = 0;
+    bool table_ready = false;
+    uint64_t written = 0;
+    for (uint64_t blocks = 0; raw_offset < end && !frame::implicitEnd(file_header, blocks); ++blocks) {
+        unsigned char block_header[frame::kBlockHeaderSize];
+        if (!in.read(reinterpret_cast<char*>(block_header), sizeof(block_header))) {
+            throw std::runtime_error("Corrupted archive: missing end of archive marker");
+        }
+        frame::BlockHeader block = frame::readBlockHeader(block_header);
+        if (block.raw_size == 0) break;
+        frame::checkBlockHeader(block, file_header);
+        uint64_t next_offset = block_offset + frame::kBlockHeaderSize + block.payload_size;
+        if (next_offset > archive_size) throw std::runtime_error("Corrupted block: unexpected end of data");
+        if (raw_offset + block.raw_size <= offset) {
+            if (block.mode == frame::BlockMode::Huffman) {
+                table_offset = block_offset;
+                table_ready = false;
+            }
+            in.seekg(block.payload_size, std::ios::cur);
+            raw_offset += block.raw_size;
+            block_offset = next_offset;
+            continue;
+        }
+
+        if (block.mode == frame::BlockMode::Repeat && !table_ready) {
+            // Таблица блока Repeat принадлежит ближайшему предыдущему блоку Huffman, который мог остаться до начала чтения.
+            for (size_t i = start_index; table_offset == 0 && i-- > 0;) {
+                if (readBlockHeaderAt(index[i].block_offset).mode == frame::BlockMode::Huffman) table_offset = index[i].block_offset;
+            }
+            if (table_offset == 0) throw std::runtime_error("Corrupted block: no table to reuse");
+            frame::BlockHeader table_block = readBlockHeaderAt(table_offset);
+            payload_buffer.resize(table_block.payload_size);
+            if (!in.read(reinterpret_cast<char*>(payload_buffer.data()), table_block.payload_size)) {
+                throw std::runtime_error("Corrupted block: unexpected end of data");
+            }
+            codec.loadTable(payload_buffer.data(), payload_buffer.size());
+            table_ready = true;
+            in.seekg(base + static_cast<std::streamoff>(block_offset + frame::kBlockHeaderSize));
+        }
+        payload_buffer.resize(block.payload_size);
+        if (!in.read(reinterpret_cast<char*>(payload_buffer.data()), block.payload_size)) {
+            throw std::runtime_error("Corrupted block: unexpected end of data");
+        }
+        raw_buffer.resize(block.raw_size);
+        codec.decode(block, payload_buffer.data(), raw_buffer.data(), dictionary);
+        if (block.mode == frame::BlockMode::Huffman) table_ready = true;
+        uint64_t from = std::max(offset, raw_offset) - raw_offset;
+        uint64_t to = std::min(end, raw_offset + block.raw_size) - raw_offset;
+        out.write(reinterpret_cast<const char*>(raw_buffer.data() + from), static_cast<std::streamsize>(to - from));
+        if (!out) throw std::runtime_error("Failed to write output file");
+        written += to - from;
+        raw_offset += block.raw_size;
+        block_offset = next_offset;
+    }
+    if (written == 0 && length > 0) throw std::runtime_error("Range is outside of archive content");
+    return written;
+}
+
+uint64_t HuffmanArchiver::compressMemoryBudget(const CompressOptions& options) {
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (options.block_size == 0) throw std::runtime_error("Invalid block size");
+    uint64_t run_size = runSize(options);
+    uint64_t encoded_size = (run_size / options.block_size) * BlockCodec::encodeBound(options.block_size);
+    uint64_t codec_size = sizeof(BlockCodec) + (options.wide_symbols ? WideCodeTable::memorySize(true) : 0);
+    return uint64_t(threads) * 2 * (run_size + encoded_size) + uint64_t(threads) * codec_size;
+}
+
+uint64_t HuffmanArchiver::decompressMemoryBudget(uint32_t block_size) {
+    uint64_t payload_size = BlockCodec::encodeBound(block_size);
+    uint64_t output_size = block_size;
+#ifdef HUFFMAN_POSIX_IO
+    output_size = std::max<uint64_t>(output_size, kOutputBufferSize);
+#endif
+    return payload_size + output_size + sizeof(HuffmanContext) + WideCodeTable::memorySize(false);
+}
+
+void HuffmanArchiver::addDictionary(std::shared_ptr<const Dictionary> dictionary) {
+    context->addDictionary(std::move(dictionary));
+}
+
+std::vector<unsigned char> HuffmanArchiver::compressBuffer(const unsigned char* data, size_t size, const CompressOptions& options) {
+    std::vector<unsigned char> out(HuffmanContext::compressBound(size, options.block_size ? options.block_size : 1));
+    out.resize(context->compress(data, size, out.data(), out.size(), options));
+    return out;
+}
+
+void HuffmanArchiver::compressBatch(const BatchInput* inputs, size_t count, BatchOutput* output, const CompressOptions& options,
+                                    bool shared_table) {
+    if (!output) throw std::runtime_error("Batch output is null");
+    if (options.block_size == 0 || options.block_size > frame::kMaxBlockSize) throw std::runtime_error("Invalid block size");
+
+    CompressOptions record_options = options;
+    if (shared_table) {
+        uint64_t counts[256] = {};
+        for (size_t i = 0; i < count; ++i) countHistogram(inputs[i].data, inputs[i].size, counts);
+        record_options.dictionary = std::make_shared<const Dictionary>(Dictionary::fromCounts(counts));
+    }
+    output->dictionary = record_options.dictionary;
+
+    size_t largest = 0;
+    size_t reserve_size = 0;
+    std::vector<std::pair<size_t, size_t>> tasks;
+    for (size_t first = 0, bytes = 0, i = 0; i < count; ++i) {
+        if (inputs[i].size == 0) throw std::runtime_error("Batch record " + std::to_string(i) + " is empty");
+        largest = std::max(largest, inputs[i].size);
+        reserve_size += inputs[i].size + kBatchRecordOverhead;
+        bytes += inputs[i].size;
+        if (bytes >= kBatchTaskSize || i + 1 == count) {
+            tasks.emplace_back(first, i + 1);
+            first = i + 1;
+            bytes = 0;
+        }
+    }
+
+    // Запись сжимается в рабочий буфер потока размером compressBound() и дописывается к выходу задачи,
+    // поэтому общий буфер не нужно заранее выделять и обнулять по верхней оценке каждой записи.
+    output->offsets.assign(count + 1, 0);
+    const size_t scratch_size = HuffmanContext::compressBound(largest, options.block_size);
+    auto encodeRecords = [&](HuffmanContext& ctx, std::vector<unsigned char>& scratch, size_t first, size_t last,
+                             std::vector<unsigned char>& out) {
+        scratch.resize(scratch_size);
+        for (size_t i = first; i < last; ++i) {
+            size_t size = ctx.compress(inputs[i].data, inputs[i].size, scratch.data(), scratch.size(), record_options);
+            out.insert(out.end(), scratch.begin(), scratch.begin() + size);
+            output->offsets[i + 1] = size;
+        }
+    };
+
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    threads = static_cast<unsigned>(std::min<size_t>(std::max(threads, 1u), tasks.size()));
+    output->arena.clear();
+    if (threads <= 1) {
+        output->arena.reserve(reserve_size);
+        std::vector<unsigned char> scratch;
+        for (const auto& task : tasks) encodeRecords(*context, scratch, task.first, task.second, output->arena);
+    } else {
+        struct Worker {
+            HuffmanContext context;
+            std::vector<unsigned char> scratch;
+        };
+        std::vector<std::unique_ptr<Worker>> workers(threads);
+        std::vector<std::vector<unsigned char>> results(tasks.size());
+        WorkStealingPool pool(threads);
+        for (size_t t = 0; t < tasks.size(); ++t) {
+            pool.submit([&, t](unsigned worker) {
+                if (!workers[worker]) workers[worker] = std::make_unique<Worker>();
+                encodeRecords(workers[worker]->context, workers[worker]->scratch, tasks[t].first, tasks[t].second, results[t]);
+            });
+        }
+        pool.wait();
+        size_t total = 0;
+        for (const auto& result : results) total += result.size();
+        output->arena.reserve(total);
+        for (const auto& result : results) output->arena.insert(output->arena.end(), result.begin(), result.end());
+    }
+    for (size_t i = 0; i < count; ++i) output->offsets[i + 1] += output->offsets[i];
+}
+
+std::vector<unsigned char> HuffmanArchiver::decompressBuffer(const unsigned char* data, size_t size) {
+    std::vector<unsigned char> out(static_cast<size_t>(HuffmanContext::contentSize(data, size)));
+    out.resize(context->decompress(data, size, out.data(), out.size()));
+    return out;
+}
@@ -1,7 +1,11 @@
 #pragma once
 #include <string>
+#include <iosfwd>
 #include <memory>
 #include <map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
 
 /**
  * @file huffman.h
@@ -12,31 +16,127 @@
  * представляющей узлы дерева Хаффмана.
  */
 struct Node {
-    /** @brief Символ, хранимый в узле (действителен для листовых узлов). */
-    unsigned char symbol;
+    /** @brief Символ, хранимый в узле (действителен для листовых узлов; алфавит до 65536 символов). */
+    uint16_t symbol;
 
     /** @brief Частота символа или сумма частот дочерних узлов. */
     uint64_t freq;
 
-    /** @brief Указатель на левый дочерний узел (nullptr для листовых узлов). */
-    std::shared_ptr<Node> left;
+    /**
+     * @brief Индекс родительского узла в массиве узлов.
+     *
+     * Дерево хранится плоским массивом без выделения памяти: листья идут первыми,
+     * внутренние узлы добавляются по мере слияния, поэтому родитель всегда имеет
+     * больший индекс, чем его потомки.
+     */
+    uint32_t parent;
+};
+
+class Dictionary;
+class HuffmanContext;
+
+/**
+ * @brief Параметры сжатия.
+ */
+struct CompressOptions {
+    /** @brief Число потоков-кодировщиков (0 — по числу аппаратных потоков). */
+    unsigned threads = 0;
+
+    /** @brief Размер блока в байтах (от 1 до frame::kMaxBlockSize). */
+    size_t block_size = 1 << 20;
+
+    /** @brief Словарь, по которому кодируются блоки (nullptr — таблица в каждом блоке). */
+    std::shared_ptr<const Dictionary> dictionary;
 
-    /** @brief Указатель на правый дочерний узел (nullptr для листовых узлов). */
-    std::shared_ptr<Node> right;
+    /** @brief Записывать индекс смещений блоков для произвольного доступа (в памяти — только для архивов из нескольких блоков). */
+    bool seek_index = true;
+
+    /** @brief Разбивать блоки по смене распределения символов (см. BlockCodec::encode()). */
+    bool adaptive_split = true;
+
+    /** @brief Размер сегмента адаптивного разбиения в байтах (не меньше kMinSplitSegmentSize). */
+    size_t split_segment = 16 * 1024;
+
+    /**
+     * @brief Строить оптимальные коды ограниченной длины алгоритмом package-merge.
+     *
+     * Без флага длины, превысившие kMaxCodeLength, укорачиваются эвристикой; разница
+     * видна только на распределениях с очень редкими символами.
+     */
+    bool optimal_lengths = false;
 
     /**
-     * @brief Конструктор листового узла с символом и частотой.
-     * @param s Символ, который будет храниться в узле.
-     * @param f Частота символа.
+     * @brief Пробовать для каждого блока коды 16-битных символов (BlockMode::Wide).
+     *
+     * Выгодно для UTF-16 и выборок int16; блок записывается в этом режиме, только
+     * если он получается меньше побайтового кодирования.
      */
-    Node(unsigned char s, uint64_t f);
+    bool wide_symbols = false;
 
     /**
-     * @brief Конструктор внутреннего узла с двумя дочерними узлами.
-     * @param l Указатель на левый дочерний узел.
-     * @param r Указатель на правый дочерний узел.
+     * @brief Возвращает параметры сжатия для уровня от 1 (быстрее) до 9 (плотнее).
+     *
+     * Уровни выбирают стратегию кодирования; потоки и словарь остаются по умолчанию.
+     * Параметры по умолчанию соответствуют уровню 6. Ориентиры получены bench/bench_huffman
+     * (сборка Release, одно ядро, синтетические корпуса по 16 МиБ: журнал и смесь журнала,
+     * двоичных и случайных данных); распаковка на всех уровнях не медленнее 120 МБ/с.
+     *
+     * | Уровень | Стратегия                                                  | Сжатие, МБ/с | Доля от исходного (журнал / смесь) |
+     * |---------|------------------------------------------------------------|--------------|------------------------------------|
+     * | 1       | блоки по 4 МиБ, без разбиения                              | ≥ 150        | ≤ 0,64 / ≤ 0,65                    |
+     * | 2       | блоки по 1 МиБ, без разбиения                              | ≥ 150        | ≤ 0,64 / ≤ 0,64                    |
+     * | 3       | разбиение по 256 КиБ                                       | ≥ 150        | ≤ 0,64 / ≤ 0,63                    |
+     * | 4–5     | разбиение по 64 / 32 КиБ                                   | ≥ 120        | ≤ 0,64 / ≤ 0,58                    |
+     * | 6       | разбиение по 16 КиБ                                        | ≥ 120        | ≤ 0,64 / ≤ 0,55                    |
+     * | 7       | разбиение по 8 КиБ                                         | ≥ 100        | ≤ 0,64 / ≤ 0,55                    |
+     * | 8–9     | разбиение по 8 / 4 КиБ, оптимальные длины (package-merge)  | ≥ 60         | ≤ 0,64 / ≤ 0,545                   |
+     *
+     * @param level Уровень сжатия от 1 до 9.
+     * @return Параметры сжатия.
+     * @throws std::runtime_error Если уровень вне диапазона.
      */
-    Node(std::shared_ptr<Node> l, std::shared_ptr<Node> r);
+    static CompressOptions fromLevel(int level);
+};
+
+/**
+ * @brief Ошибка обработки одного файла в пакетном режиме.
+ */
+struct FileError {
+    /** @brief Путь к файлу. */
+    std::string path;
+
+    /** @brief Текст ошибки. */
+    std::string message;
+};
+
+/**
+ * @brief Одна запись пакета для HuffmanArchiver::compressBatch().
+ */
+struct BatchInput {
+    /** @brief Данные записи. */
+    const unsigned char* data = nullptr;
+
+    /** @brief Размер данных записи (больше 0). */
+    size_t size = 0;
+};
+
+/**
+ * @brief Результат HuffmanArchiver::compressBatch(): все архивы записей в одном буфере.
+ */
+struct BatchOutput {
+    /** @brief Архивы записей подряд, в порядке входа. */
+    std::vector<unsigned char> arena;
+
+    /** @brief Смещения архивов в arena; архив записи i занимает [offsets[i], offsets[i + 1]). */
+    std::vector<size_t> offsets;
+
+    /**
+     * @brief Словарь, на который ссылаются архивы (nullptr — таблица в каждом архиве).
+     *
+     * Для распаковки словарь нужно зарегистрировать через addDictionary() или
+     * сохранить вместе с архивами (Dictionary::save()).
+     */
+    std::shared_ptr<const Dictionary> dictionary;
 };
 
 /**
@@ -56,58 +156,137 @@ private:
     std::map<unsigned char, uint64_t> freq_table;
 
     /** 
-     * @brief Таблица, отображающая символы на их коды Хаффмана.
+     * @brief Таблица, отображающая символы на их коды Хаффмана (коды первого блока).
      */
     std::map<unsigned char, std::string> huffman_codes;
 
     /** 
-     * @brief Указатель на корень дерева Хаффмана.
+     * @brief Контекст для операций в памяти и распаковки: таблицы, словари и кодек
+     * переиспользуются между вызовами.
      */
-    std::shared_ptr<Node> root;
+    std::unique_ptr<HuffmanContext> context;
 
-    /**
-     * @brief Создает таблицу частот из входного файла.
-     * @param input_file Путь к входному файлу.
-     * @throws std::runtime_error Если входной файл не удается открыть.
+    /** 
+     * @brief Буфер полезной нагрузки блока при распаковке.
      */
-    void buildFrequencyTable(const std::string& input_file);
+    std::vector<unsigned char> payload_buffer;
 
-    /**
-     * @brief Строит дерево Хаффмана на основе таблицы частот.
+    /** 
+     * @brief Буфер исходных данных блока при распаковке.
      */
-    void buildHuffmanTree();
+    std::vector<unsigned char> raw_buffer;
+
+public:
+    HuffmanArchiver();
+    ~HuffmanArchiver();
 
     /**
-     * @brief Генерирует коды Хаффмана, обходя дерево Хаффмана.
-     * @param node Указатель на текущий узел дерева.
-     * @param code Текущий код, формируемый (строка из '0' и '1').
+     * @brief Регистрирует словарь для распаковки архивов, которые на него ссылаются.
+     * @param dictionary Загруженный словарь; разделяется, а не копируется.
+     * @throws std::runtime_error Если dictionary равен nullptr.
      */
-    void buildHuffmanCodes(const std::shared_ptr<Node>& node, const std::string& code);
+    void addDictionary(std::shared_ptr<const Dictionary> dictionary);
 
     /**
-     * @brief Записывает таблицу частот в выходной поток.
-     * @param out Выходной поток для записи таблицы частот.
+     * @brief Сжимает буфер в памяти в архив того же формата, что и compress().
+     *
+     * Блоки кодируются последовательно в вызывающем потоке; с options.dictionary
+     * в архив не записываются таблицы частот, что выгодно для маленьких сообщений.
+     *
+     * @param data Исходные данные.
+     * @param size Размер исходных данных.
+     * @param options Параметры сжатия (threads не используется).
+     * @return Сжатые данные.
+     * @throws std::runtime_error Если вход пуст или параметры неверны.
      */
-    void writeFrequencyTable(std::ofstream& out);
+    std::vector<unsigned char> compressBuffer(const unsigned char* data, size_t size, const CompressOptions& options = {});
 
     /**
-     * @brief Считывает таблицу частот из входного потока.
-     * @param in Входной поток для чтения таблицы частот.
-     * @throws std::runtime_error Если таблица частот повреждена или не может быть прочитана.
+     * @brief Распаковывает архив, находящийся в памяти.
+     * @param data Сжатые данные.
+     * @param size Размер сжатых данных.
+     * @return Распакованные данные.
+     * @throws std::runtime_error Если архив поврежден или ссылается на незарегистрированный словарь.
      */
-    void readFrequencyTable(std::ifstream& in);
+    std::vector<unsigned char> decompressBuffer(const unsigned char* data, size_t size);
 
-public:
     /**
      * @brief Сжимает входной файл с использованием кодирования Хаффмана.
+     *
+     * Сжатие выполняется конвейером из трех стадий: поток чтения заполняет блоки
+     * из пула переиспользуемых буферов, пул кодировщиков кодирует блоки независимо,
+     * а поток записи выводит их в исходном порядке. Очереди между стадиями ограничены,
+     * поэтому в памяти одновременно находится не более 2 × threads блоков.
+     *
      * @param input_file Путь к входному файлу для сжатия.
      * @param output_file Путь к выходному сжатому файлу.
+     * @param options Параметры сжатия.
      * @throws std::runtime_error Если файлы не удается открыть, входной файл пуст или сжатие не удалось.
      */
-    void compress(const std::string& input_file, const std::string& output_file);
+    void compress(const std::string& input_file, const std::string& output_file, const CompressOptions& options = {});
+
+    /**
+     * @brief Сжимает данные из потока тем же конвейером, что и compress().
+     * @param in Входной поток; читается до конца.
+     * @param out Выходной поток; архив записывается с текущей позиции.
+     * @param options Параметры сжатия.
+     * @throws std::runtime_error Если вход пуст, параметры неверны или запись не удалась.
+     */
+    void compressStream(std::istream& in, std::ostream& out, const CompressOptions& options = {});
+
+    /**
+     * @brief Сжимает набор файлов, каждый в соседний файл с суффиксом ".huff".
+     *
+     * Работа распределяется по пулу потоков с перехватом задач. Файлы не больше
+     * options.block_size объединяются в пакеты примерно по block_size байт, а
+     * большие файлы делятся на прогоны, которые кодируются независимо и
+     * записываются по порядку по мере готовности. В памяти держится не больше
+     * threads закодированных прогонов файла; при ошибке частичный архив
+     * удаляется. Кодек и буфер чтения у каждого рабочего потока свои и
+     * переиспользуются между задачами.
+     *
+     * @param input_files Пути к входным файлам.
+     * @param options Параметры сжатия (threads задает размер пула).
+     * @return Ошибки по файлам, которые не удалось сжать; пустой вектор при полном успехе.
+     */
+    std::vector<FileError> compressMany(const std::vector<std::string>& input_files, const CompressOptions& options = {});
+
+    /**
+     * @brief Сжимает набор маленьких буферов за один вызов.
+     *
+     * Каждая запись сжимается в отдельный архив того же формата, что и compressBuffer(),
+     * но без выделения памяти на каждую запись. Записи делятся на задачи примерно
+     * по 256 КиБ. Запись сжимается в рабочий буфер потока размером compressBound()
+     * самой большой записи и дописывается к выходу задачи; в каждом потоке свои
+     * контекст и рабочий буфер, которые переиспользуются между записями.
+     *
+     * При одной задаче или одном потоке выходом служит сам arena, заранее
+     * зарезервированный по суммарному размеру входа. Если задач больше одной, они
+     * кодируются пулом потоков в собственные векторы, которые затем по порядку
+     * копируются в arena; такие архивы копируются дважды — из рабочего буфера в
+     * вектор задачи и из него в arena.
+     *
+     * С shared_table вход проходится один раз для общей гистограммы, по которой
+     * строится словарь (Dictionary::fromCounts()); архивы записей на него ссылаются
+     * и не содержат таблиц частот.
+     *
+     * @param inputs Записи.
+     * @param count Число записей.
+     * @param output Результат; предыдущее содержимое заменяется.
+     * @param options Параметры сжатия (threads задает размер пула, dictionary используется, если shared_table не задан).
+     * @param shared_table Построить одну таблицу кодов на весь пакет.
+     * @throws std::runtime_error Если output равен nullptr, запись пуста или параметры неверны.
+     */
+    void compressBatch(const BatchInput* inputs, size_t count, BatchOutput* output, const CompressOptions& options = {},
+                       bool shared_table = false);
 
     /**
      * @brief Распаковывает архив, закодированный алгоритмом Хаффмана.
+     *
+     * Если в заголовке записан исходный размер, выходной файл заранее выделяется
+     * целиком (posix_fallocate, иначе ftruncate), а блоки декодируются в большой буфер
+     * и сбрасываются через pwrite; без размера вывод идет через std::ofstream.
+     *
      * @param input_file Путь к сжатому входному файлу.
      * @param output_file Путь к выходному распакованному файлу.
      * @param write_freq Если true, записывает таблицу частот в файл с суффиксом "_freq.txt".
@@ -116,7 +295,91 @@ public:
     void decompress(const std::string& input_file, const std::string& output_file, bool write_freq = false);
 
     /**
-     * @brief Возвращает таблицу кодов Хаффмана (только для тестирования).
+     * @brief Распаковывает один архив, начинающийся с текущей позиции потока.
+     *
+     * Поток читается ровно до признака конца архива, поэтому за архивом могут
+     * следовать другие данные (например, в контейнере).
+     *
+     * @param in Входной поток, установленный на заголовок архива.
+     * @param out Выходной поток для распакованных данных.
+     * @throws std::runtime_error Если архив пуст, поврежден или запись не удалась.
+     */
+    void decompressStream(std::istream& in, std::ostream& out);
+
+    /**
+     * @brief Проверяет целостность архива, не записывая распакованные данные.
+     *
+     * Блоки декодируются параллельно во временные буферы рабочих потоков, и для
+     * каждого сверяется CRC32C; затем суммы блоков объединяются и сравниваются
+     * с контрольной суммой всего содержимого.
+     *
+     * @param input_file Путь к архиву.
+     * @param threads Число рабочих потоков (0 — по числу аппаратных потоков).
+     * @return Исходный размер содержимого архива.
+     * @throws std::runtime_error Если архив не удается открыть или он поврежден.
+     */
+    uint64_t verify(const std::string& input_file, unsigned threads = 0);
+
+    /**
+     * @brief Проверяет целостность одного архива, начинающегося с текущей позиции потока.
+     * @param in Входной поток, установленный на заголовок архива.
+     * @param threads Число рабочих потоков (0 — по числу аппаратных потоков).
+     * @return Исходный размер содержимого архива.
+     * @throws std::runtime_error Если архив поврежден.
+     */
+    uint64_t verifyStream(std::istream& in, unsigned threads = 0);
+
+    /**
+     * @brief Распаковывает диапазон исходного содержимого архива.
+     *
+     * По индексу блоков находится блок, содержащий начало диапазона, и декодируются
+     * только блоки, покрывающие диапазон. Архив без индекса просматривается по
+     * заголовкам блоков без декодирования пропускаемых блоков.
+     *
+     * @param input_file Путь к архиву.
+     * @param offset Смещение начала диапазона в исходном содержимом.
+     * @param length Длина диапазона; обрезается по концу содержимого.
+     * @param output_file Путь к выходному файлу.
+     * @return Число записанных байт.
+     * @throws std::runtime_error Если архив поврежден или диапазон начинается за концом содержимого.
+     */
+    uint64_t extractRange(const std::string& input_file, uint64_t offset, uint64_t length, const std::string& output_file);
+
+    /**
+     * @brief Распаковывает диапазон исходного содержимого архива из потока.
+     * @param in Входной поток с произвольным доступом, установленный на заголовок архива.
+     * @param archive_size Размер архива в потоке (включая индекс).
+     * @param offset Смещение начала диапазона в исходном содержимом.
+     * @param length Длина диапазона; обрезается по концу содержимого.
+     * @param out Выходной поток.
+     * @return Число записанных байт.
+     * @throws std::runtime_error Если архив поврежден или диапазон начинается за концом содержимого.
+     */
+    uint64_t extractRangeStream(std::istream& in, uint64_t archive_size, uint64_t offset, uint64_t length, std::ostream& out);
+
+    /**
+     * @brief Оценивает память, которую занимают буферы и таблицы сжатия файла или потока.
+     *
+     * Конвейер создает 2 × threads буферов серии блоков (исходные данные и результат),
+     * которые переиспользуются между сериями и файлами; кодеки рабочих потоков
+     * хранят таблицы в массивах фиксированного размера. После заполнения буферов
+     * конвейер не обращается к распределителю памяти на каждый блок.
+     *
+     * @param options Параметры сжатия.
+     * @return Объем памяти в байтах.
+     * @throws std::runtime_error Если размер блока равен 0.
+     */
+    static uint64_t compressMemoryBudget(const CompressOptions& options);
+
+    /**
+     * @brief Оценивает память, которую занимают буферы и таблицы распаковки.
+     * @param block_size Размер блока архива (см. заголовок архива).
+     * @return Объем памяти в байтах.
+     */
+    static uint64_t decompressMemoryBudget(uint32_t block_size);
+
+    /**
+     * @brief Возвращает таблицу кодов Хаффмана первого блока (только для тестирования).
      * @return Константная ссылка на карту символов и их кодов Хаффмана.
      */
     const std::map<unsigned char, std::string>& getHuffmanCodes() const { return huffman_codes; }
@@ -0,0 +1,78 @@
+#include "huffman_c.h"
+#include "huffman_context.h"
+#include <new>
+#include <stdexcept>
+
+struct huff_ctx {
+    HuffmanContext context;
+};
+
+namespace {
+
+template <typename Function>
+int guarded(int failure, Function function) {
+    try {
+        return function();
+    } catch (const std::bad_alloc&) {
+        return HUFF_ERROR_OUT_OF_MEMORY;
+    } catch (const std::exception&) {
+        return failure;
+    }
+}
+
+}
+
+huff_ctx* huff_ctx_create(void) {
+    return new (std::nothrow) huff_ctx;
+}
+
+void huff_ctx_free(huff_ctx* ctx) {
+    delete ctx;
+}
+
+size_t huff_compress_bound(size_t src_size) {
+    return HuffmanContext::compressBound(src_size, CompressOptions().block_size);
+}
+
+int huff_compress(huff_ctx* ctx, const void* src, size_t src_size, void* dst, size_t dst_capacity, int level, size_t* dst_size) {
+    if (!ctx || !src || !dst || !dst_size || src_size == 0 || level < 0 || level > 9) return HUFF_ERROR_INVALID_ARGUMENT;
+    return guarded(HUFF_ERROR_INVALID_ARGUMENT, [&] {
+        CompressOptions options = level ? CompressOptions::fromLevel(level) : CompressOptions();
+        if (dst_capacity < HuffmanContext::compressBound(src_size, options.block_size)) return HUFF_ERROR_BUFFER_TOO_SMALL;
+        *dst_size = ctx->context.compress(static_cast<const unsigned char*>(src), src_size, static_cast<unsigned char*>(dst), dst_capacity,
+                                          options);
+        return HUFF_OK;
+    });
+}
+
+int huff_content_size(const void* src, size_t src_size, uint64_t* content_size) {
+    if (!src || !content_size) return HUFF_ERROR_INVALID_ARGUMENT;
+    return guarded(HUFF_ERROR_CORRUPTED, [&] {
+        *content_size = HuffmanContext::contentSize(static_cast<const unsigned char*>(src), src_size);
+        return HUFF_OK;
+    });
+}
+
+int huff_decompress(huff_ctx* ctx, const void* src, size_t src_size, void* dst, size_t dst_capacity, size_t* dst_size) {
+    if (!ctx || !src || !dst || !dst_size) return HUFF_ERROR_INVALID_ARGUMENT;
+    return guarded(HUFF_ERROR_CORRUPTED, [&] {
+        const unsigned char* archive = static_cast<const unsigned char*>(src);
+        uint64_t content_size = HuffmanContext::contentSize(archive, src_size);
+        if (frame::readHeader(archive).flags & frame::kFlagDictionary) return HUFF_ERROR_UNSUPPORTED;
+        if (content_size > dst_capacity) return HUFF_ERROR_BUFFER_TOO_SMALL;
+        *dst_size = ctx->context.decompress(archive, src_size, static_cast<unsigned char*>(dst), dst_capacity);
+        return HUFF_OK;
+    });
+}
+
+const char* huff_status_string(int status) {
+    switch (status) {
+    case HUFF_OK: return "OK";
+    case HUFF_ERROR_INVALID_ARGUMENT: return "Invalid argument";
+    case HUFF_ERROR_BUFFER_TOO_SMALL: return "Output buffer is too small";
+    case HUFF_ERROR_CORRUPTED: return "Archive is corrupted or unsupported";
+    case HUFF_ERROR_UNSUPPORTED: return "Archive requires a dictionary";
+    case HUFF_ERROR_OUT_OF_MEMORY: return "Out of memory";
+    default: return "Unknown status";
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef HUFFMAN_C_H
+#define HUFFMAN_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file huffman_c.h
+ * @brief Стабильный C API библиотеки huffman_core для встраивания в другие сервисы.
+ *
+ * Функции не выбрасывают исключений и сообщают об ошибках кодами huff_status,
+ * поэтому их можно вызывать из C и через FFI (например, ctypes в Python при сборке
+ * с -DBUILD_SHARED_LIBS=ON). Формат результата совпадает с форматом файлов .huff.
+ *
+ * Контекст не потокобезопасен: каждому потоку нужен собственный huff_ctx.
+ * Совместимость гарантируется в пределах одного значения HUFF_API_VERSION.
+ */
+
+#if defined(_WIN32)
+#define HUFF_API __declspec(dllexport)
+#else
+#define HUFF_API __attribute__((visibility("default")))
+#endif
+
+/** @brief Версия C API; меняется только при несовместимых изменениях. */
+#define HUFF_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Коды результата функций C API. */
+typedef enum huff_status {
+    /** @brief Успех. */
+    HUFF_OK = 0,
+
+    /** @brief Неверный аргумент: нулевой указатель, пустой вход или уровень вне 0..9. */
+    HUFF_ERROR_INVALID_ARGUMENT = -1,
+
+    /** @brief Выходной буфер меньше необходимого. */
+    HUFF_ERROR_BUFFER_TOO_SMALL = -2,
+
+    /** @brief Архив поврежден или имеет неподдерживаемый формат. */
+    HUFF_ERROR_CORRUPTED = -3,
+
+    /** @brief Архив требует словарь, который через C API не передается. */
+    HUFF_ERROR_UNSUPPORTED = -4,
+
+    /** @brief Не удалось выделить память. */
+    HUFF_ERROR_OUT_OF_MEMORY = -5,
+} huff_status;
+
+/** @brief Непрозрачный контекст сжатия и распаковки (см. HuffmanContext). */
+typedef struct huff_ctx huff_ctx;
+
+/**
+ * @brief Создает контекст.
+ * @return Контекст или NULL, если не хватило памяти.
+ */
+HUFF_API huff_ctx* huff_ctx_create(void);
+
+/**
+ * @brief Освобождает контекст.
+ * @param ctx Контекст (NULL допускается).
+ */
+HUFF_API void huff_ctx_free(huff_ctx* ctx);
+
+/**
+ * @brief Возвращает размер буфера, достаточный для huff_compress() на любом уровне.
+ * @param src_size Размер исходных данных.
+ * @return Верхняя граница размера сжатых данных.
+ */
+HUFF_API size_t huff_compress_bound(size_t src_size);
+
+/**
+ * @brief Сжимает данные в памяти.
+ * @param ctx Контекст.
+ * @param src Исходные данные.
+ * @param src_size Размер исходных данных (больше 0).
+ * @param dst Выходной буфер.
+ * @param dst_capacity Размер выходного буфера (достаточно huff_compress_bound(src_size)).
+ * @param level Уровень сжатия от 1 до 9 (0 — уровень по умолчанию).
+ * @param dst_size Размер записанных данных при успехе.
+ * @return HUFF_OK или код ошибки.
+ */
+HUFF_API int huff_compress(huff_ctx* ctx, const void* src, size_t src_size, void* dst, size_t dst_capacity, int level,
+                           size_t* dst_size);
+
+/**
+ * @brief Возвращает исходный размер содержимого архива без распаковки.
+ * @param src Архив.
+ * @param src_size Размер архива.
+ * @param content_size Исходный размер при успехе.
+ * @return HUFF_OK или код ошибки.
+ */
+HUFF_API int huff_content_size(const void* src, size_t src_size, uint64_t* content_size);
+
+/**
+ * @brief Распаковывает архив в памяти.
+ * @param ctx Контекст.
+ * @param src Архив.
+ * @param src_size Размер архива.
+ * @param dst Выходной буфер.
+ * @param dst_capacity Размер выходного буфера (достаточно huff_content_size()).
+ * @param dst_size Размер распакованных данных при успехе.
+ * @return HUFF_OK или код ошибки.
+ */
+HUFF_API int huff_decompress(huff_ctx* ctx, const void* src, size_t src_size, void* dst, size_t dst_capacity, size_t* dst_size);
+
+/**
+ * @brief Возвращает описание кода результата.
+ * @param status Код результата.
+ * @return Строка со статическим временем жизни.
+ */
+HUFF_API const char* huff_status_string(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+#include "huffman_context.h"
+#include "dictionary.h"
+#include "checksum.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+size_t HuffmanContext::compressBound(size_t size, size_t block_size) {
+    if (block_size == 0) block_size = 1;
+    size_t blocks = size / block_size + BlockCodec::maxBlocks(size);
+    return frame::kMaxHeaderSize + blocks * BlockCodec::encodeBound(0) + CodeTable::encodedBound(size) + frame::kBlockHeaderSize +
+           frame::indexSize(blocks);
+}
+
+uint64_t HuffmanContext::contentSize(const unsigned char* src, size_t size) {
+    if (size < frame::kHeaderSize) throw std::runtime_error("Archive is empty or corrupted");
+    frame::Header header = frame::readHeader(src);
+    size_t pos = frame::headerSize(header.flags);
+    if (size < pos) throw std::runtime_error("Archive is empty or corrupted");
+    frame::readHeaderExtension(header, src + frame::kHeaderSize);
+    uint64_t total = 0;
+    for (uint64_t blocks = 0;; ++blocks) {
+        frame::BlockHeader block;
+        if (!frame::implicitEnd(header, blocks)) {
+            if (size - pos < frame::kBlockHeaderSize) throw std::runtime_error("Corrupted archive: missing end of archive marker");
+            block = frame::readBlockHeader(src + pos);
+            pos += frame::kBlockHeaderSize;
+        }
+        if (block.raw_size == 0) {
+            if ((header.flags & frame::kFlagContentSize) && total != header.content_size) {
+                throw std::runtime_error("Corrupted archive: content size mismatch");
+            }
+            return total;
+        }
+        if (size - pos < block.payload_size) throw std::runtime_error("Corrupted block: unexpected end of data");
+        pos += block.payload_size;
+        total += block.raw_size;
+    }
+}
+
+void HuffmanContext::addDictionary(std::shared_ptr<const Dictionary> dictionary) {
+    if (!dictionary) throw std::runtime_error("Dictionary is null");
+    dictionaries[dictionary->getId()] = std::move(dictionary);
+}
+
+const Dictionary* HuffmanContext::findDictionary(const frame::Header& header) const {
+    if (!(header.flags & frame::kFlagDictionary)) return nullptr;
+    auto it = dictionaries.find(header.dictionary_id);
+    if (it == dictionaries.end()) throw std::runtime_error("Unknown dictionary: " + std::to_string(header.dictionary_id));
+    return it->second.get();
+}
+
+size_t HuffmanContext::compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity, const CompressOptions& options) {
+    if (size == 0) throw std::runtime_error("Input file is empty");
+    if (options.block_size == 0 || options.block_size > frame::kMaxBlockSize) throw std::runtime_error("Invalid block size");
+    if (capacity < compressBound(size, options.block_size)) throw std::runtime_error("Output buffer is too small");
+
+    frame::Header header = frame::makeHeader(options, size);
+    frame::writeHeader(header, dst);
+    codec.reset();
+    codec.setOptimalLengths(options.optimal_lengths);
+    codec.setWideSymbols(options.wide_symbols);
+    size_t pos = frame::headerSize(header.flags);
+    frame::BlockHeader end_marker;
+    size_t blocks = 0;
+    for (size_t offset = 0; offset < size; offset += options.block_size) {
+        size_t length = std::min(options.block_size, size - offset);
+        size_t end = pos + codec.encode(src + offset, length, dst + pos, options.dictionary.get(), options.adaptive_split ? options.split_segment : 0);
+        while (pos < end) {
+            frame::BlockHeader block = frame::readBlockHeader(dst + pos);
+            end_marker.checksum = crc32cCombine(end_marker.checksum, block.checksum, block.raw_size);
+            pos += frame::kBlockHeaderSize + block.payload_size;
+            ++blocks;
+        }
+    }
+    if (blocks == 1) {
+        // Для короткого сообщения размер в заголовке, признак конца и индекс из одной записи
+        // занимают заметную долю архива, а все их поля повторяют заголовок единственного блока.
+        size_t start = frame::headerSize(header.flags);
+        header.flags = (header.flags & ~(frame::kFlagContentSize | frame::kFlagIndex)) | frame::kFlagSingleBlock;
+        header.content_size = 0;
+        frame::writeHeader(header, dst);
+        std::memmove(dst + frame::headerSize(header.flags), dst + start, pos - start);
+        return frame::headerSize(header.flags) + (pos - start);
+    }
+    frame::writeBlockHeader(end_marker, dst + pos);
+    pos += frame::kBlockHeaderSize;
+    if (!(header.flags & frame::kFlagIndex)) return pos;
+
+    frame::IndexEntry entry;
+    entry.block_offset = frame::headerSize(header.flags);
+    uint32_t count = 0;
+    for (frame::BlockHeader block = frame::readBlockHeader(dst + entry.block_offset); block.raw_size != 0;
+         block = frame::readBlockHeader(dst + entry.block_offset)) {
+        frame::writeIndexEntry(entry, dst + pos);
+        pos += frame::kIndexEntrySize;
+        entry.block_offset += frame::kBlockHeaderSize + block.payload_size;
+        entry.raw_offset += block.raw_size;
+        ++count;
+    }
+    frame::writeIndexFooter(count, dst + pos);
+    return pos + frame::kIndexFooterSize;
+}
+
+size_t HuffmanContext::decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) {
+    if (size < frame::kHeaderSize) throw std::runtime_error("Archive is empty or corrupted");
+    frame::Header header = frame::readHeader(src);
+    size_t pos = frame::headerSize(header.flags);
+    if (size < pos) throw std::runtime_error("Archive is empty or corrupted");
+    frame::readHeaderExtension(header, src + frame::kHeaderSize);
+    const Dictionary* dictionary = findDictionary(header);
+    codec.reset();
+    codec.setOptimalLengths(header.flags & frame::kFlagOptimalLengths);
+    bool sized = header.flags & frame::kFlagContentSize;
+    if (sized && capacity < header.content_size) throw std::runtime_error("Output buffer is too small");
+
+    size_t written = 0;
+    uint32_t checksum = 0;
+    for (uint64_t blocks = 0;; ++blocks) {
+        frame::BlockHeader block;
+        if (frame::implicitEnd(header, blocks)) {
+            block.checksum = checksum;
+        } else {
+            if (size - pos < frame::kBlockHeaderSize) throw std::runtime_error("Corrupted archive: missing end of archive marker");
+            block = frame::readBlockHeader(src + pos);
+            pos += frame::kBlockHeaderSize;
+        }
+        if (block.raw_size == 0) {
+            if (block.checksum != checksum) throw std::runtime_error("Corrupted archive: content checksum mismatch");
+            if (sized && written != header.content_size) throw std::runtime_error("Corrupted archive: content size mismatch");
+            return written;
+        }
+        frame::checkBlockHeader(block, header);
+        if (size - pos < block.payload_size) throw std::runtime_error("Corrupted block: unexpected end of data");
+        if (capacity - written < block.raw_size) throw std::runtime_error("Output buffer is too small");
+        codec.decode(block, src + pos, dst + written, dictionary);
+        checksum = crc32cCombine(checksum, block.checksum, block.raw_size);
+        pos += block.payload_size;
+        written += block.raw_size;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "huffman.h"
+#include "block_codec.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+/**
+ * @file huffman_context.h
+ * @brief Переиспользуемый контекст для сжатия и распаковки в памяти без выделений.
+ */
+
+/**
+ * @class HuffmanContext
+ * @brief Контекст сжатия в памяти, который не выделяет память в установившемся режиме.
+ *
+ * Все таблицы (гистограмма, длины и коды, таблица декодирования) имеют
+ * фиксированный размер и живут внутри контекста, а данные пишутся в буферы
+ * вызывающего кода. После первого вызова compress()/decompress() не обращаются
+ * к распределителю памяти (кроме путей, выбрасывающих исключения). Формат
+ * результата совпадает с форматом файлов .huff.
+ *
+ * Контекст не потокобезопасен: каждому потоку нужен собственный экземпляр.
+ */
+class HuffmanContext {
+private:
+    /** @brief Кодек блоков с таблицами фиксированного размера. */
+    BlockCodec codec;
+
+    /** @brief Зарегистрированные словари по идентификатору. */
+    std::map<uint32_t, std::shared_ptr<const Dictionary>> dictionaries;
+
+public:
+    /**
+     * @brief Возвращает верхнюю границу размера сжатых данных.
+     * @param size Размер исходных данных.
+     * @param block_size Размер блока, с которым будет вызван compress().
+     * @return Размер буфера, достаточный для compress().
+     */
+    static size_t compressBound(size_t size, size_t block_size = CompressOptions().block_size);
+
+    /**
+     * @brief Возвращает размер исходных данных архива, просматривая только заголовки блоков.
+     * @param src Сжатые данные.
+     * @param size Размер сжатых данных.
+     * @return Суммарный исходный размер блоков.
+     * @throws std::runtime_error Если архив поврежден.
+     */
+    static uint64_t contentSize(const unsigned char* src, size_t size);
+
+    /**
+     * @brief Регистрирует словарь для сжатия и распаковки.
+     * @param dictionary Загруженный словарь.
+     * @throws std::runtime_error Если dictionary равен nullptr.
+     */
+    void addDictionary(std::shared_ptr<const Dictionary> dictionary);
+
+    /**
+     * @brief Находит словарь, на который ссылается заголовок архива.
+     * @param header Заголовок архива.
+     * @return Словарь или nullptr, если архив не использует словарь.
+     * @throws std::runtime_error Если словарь с нужным идентификатором не зарегистрирован.
+     */
+    const Dictionary* findDictionary(const frame::Header& header) const;
+
+    /**
+     * @brief Возвращает кодек блоков контекста.
+     * @return Ссылка на кодек.
+     */
+    BlockCodec& getCodec() { return codec; }
+
+    /**
+     * @brief Сжимает буфер в заранее выделенный выходной буфер.
+     *
+     * Архив из одного блока записывается в компактной форме (frame::kFlagSingleBlock):
+     * без исходного размера в заголовке, признака конца и индекса блоков, даже при
+     * options.seek_index — диапазон в нем все равно декодируется целиком.
+     *
+     * @param src Исходные данные.
+     * @param size Размер исходных данных (больше 0).
+     * @param dst Выходной буфер.
+     * @param capacity Размер выходного буфера; не меньше compressBound(size, options.block_size).
+     * @param options Параметры сжатия (threads не используется).
+     * @return Размер сжатых данных.
+     * @throws std::runtime_error Если вход пуст, параметры неверны или буфер слишком мал.
+     */
+    size_t compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity, const CompressOptions& options = {});
+
+    /**
+     * @brief Распаковывает архив в заранее выделенный выходной буфер.
+     * @param src Сжатые данные.
+     * @param size Размер сжатых данных.
+     * @param dst Выходной буфер.
+     * @param capacity Размер выходного буфера.
+     * @return Размер распакованных данных.
+     * @throws std::runtime_error Если архив поврежден, словарь не зарегистрирован или буфер слишком мал.
+     */
+    size_t decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity);
+};
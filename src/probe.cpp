@@ -0,0 +1,101 @@
+#include "probe.h"
+#include "block_codec.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct SampleStats {
+    uint64_t counts[256] = {};
+    uint64_t sampled = 0;
+    double coded_bits = 0;
+    double table_bytes = 0;
+    unsigned samples = 0;
+};
+
+void addSample(SampleStats& stats, const unsigned char* data, size_t size) {
+    CodeTable table;
+    countHistogram(data, size, table.freq);
+    table.buildLengths();
+    for (int s = 0; s < 256; ++s) stats.counts[s] += table.freq[s];
+    stats.sampled += size;
+    stats.samples++;
+    if (table.symbol_count == 1) return;
+    double bits = static_cast<double>(table.encodedBits());
+    if (bits + table.frequencyTableSize() * 8 >= size * 8.0) {
+        stats.coded_bits += size * 8.0;
+    } else {
+        stats.coded_bits += bits;
+        stats.table_bytes += table.frequencyTableSize();
+    }
+}
+
+std::vector<uint64_t> sampleOffsets(uint64_t size, const ProbeOptions& options) {
+    std::vector<uint64_t> offsets;
+    unsigned samples = std::max(1u, options.samples);
+    if (size <= uint64_t(samples) * options.sample_size) {
+        for (uint64_t offset = 0; offset < size; offset += options.sample_size) offsets.push_back(offset);
+        return offsets;
+    }
+    uint64_t span = size - options.sample_size;
+    for (unsigned i = 0; i < samples; ++i) {
+        offsets.push_back(samples == 1 ? 0 : span * i / (samples - 1));
+    }
+    return offsets;
+}
+
+ProbeResult finish(const SampleStats& stats, uint64_t size, const ProbeOptions& options) {
+    ProbeResult result;
+    result.size = size;
+    result.sampled = stats.sampled;
+    if (size == 0 || stats.sampled == 0) return result;
+
+    for (int s = 0; s < 256; ++s) {
+        if (stats.counts[s]) result.entropy += stats.counts[s] * std::log2(static_cast<double>(stats.sampled) / stats.counts[s]);
+    }
+    result.entropy /= stats.sampled;
+
+    uint64_t block_size = std::max<size_t>(1, options.block_size);
+    uint64_t blocks = (size + block_size - 1) / block_size;
+    double payload = stats.coded_bits / 8 / stats.sampled * size;
+    double tables = stats.table_bytes / stats.samples * blocks;
+    double framing = frame::kHeaderSize + (blocks + 1) * frame::kBlockHeaderSize + frame::indexSize(blocks);
+    result.estimated_size = static_cast<uint64_t>(std::min(payload + tables, static_cast<double>(size)) + framing);
+    result.ratio = static_cast<double>(result.estimated_size) / size;
+    return result;
+}
+
+}
+
+ProbeResult probe(const unsigned char* data, size_t size, const ProbeOptions& options) {
+    if (options.sample_size == 0) throw std::runtime_error("Invalid sample size");
+    SampleStats stats;
+    for (uint64_t offset : sampleOffsets(size, options)) {
+        addSample(stats, data + offset, std::min<uint64_t>(options.sample_size, size - offset));
+    }
+    return finish(stats, size, options);
+}
+
+ProbeResult probeFile(const std::string& path, const ProbeOptions& options) {
+    if (options.sample_size == 0) throw std::runtime_error("Invalid sample size");
+    std::ifstream in(path, std::ios::binary);
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (!in || ec) throw std::runtime_error("Failed to open input file");
+
+    SampleStats stats;
+    std::vector<unsigned char> buffer(options.sample_size);
+    for (uint64_t offset : sampleOffsets(size, options)) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(options.sample_size, size - offset));
+        in.seekg(static_cast<std::streamoff>(offset));
+        if (!in.read(reinterpret_cast<char*>(buffer.data()), length)) throw std::runtime_error("Failed to read input file");
+        addSample(stats, buffer.data(), length);
+    }
+    return finish(stats, size, options);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @file probe.h
+ * @brief Быстрая оценка сжимаемости данных без кодирования.
+ */
+
+/**
+ * @brief Параметры оценки сжимаемости.
+ */
+struct ProbeOptions {
+    /** @brief Число выборок, равномерно распределенных по данным. */
+    unsigned samples = 16;
+
+    /** @brief Размер одной выборки в байтах. */
+    size_t sample_size = 64 * 1024;
+
+    /** @brief Размер блока, с которым данные будут сжиматься (для учета заголовков и таблиц). */
+    size_t block_size = 1 << 20;
+};
+
+/**
+ * @brief Результат оценки сжимаемости.
+ */
+struct ProbeResult {
+    /** @brief Размер исходных данных. */
+    uint64_t size = 0;
+
+    /** @brief Число байт, попавших в выборки. */
+    uint64_t sampled = 0;
+
+    /** @brief Энтропия Шеннона выборок в битах на байт. */
+    double entropy = 0;
+
+    /** @brief Оценка размера сжатых данных по длинам кодов с учетом заголовков, таблиц и несжимаемых блоков. */
+    uint64_t estimated_size = 0;
+
+    /** @brief Отношение estimated_size к size (1 — сжатие бесполезно). */
+    double ratio = 1;
+};
+
+/**
+ * @brief Оценивает сжимаемость буфера по выборкам.
+ *
+ * Для каждой выборки считается гистограмма и строятся длины кодов (без
+ * кодирования); выборка, которую выгоднее хранить как есть, учитывается
+ * по исходному размеру. Результат экстраполируется на весь буфер.
+ *
+ * @param data Данные.
+ * @param size Размер данных.
+ * @param options Параметры выборки.
+ * @return Оценка сжимаемости.
+ */
+ProbeResult probe(const unsigned char* data, size_t size, const ProbeOptions& options = {});
+
+/**
+ * @brief Оценивает сжимаемость файла, читая только выборки.
+ * @param path Путь к файлу.
+ * @param options Параметры выборки.
+ * @return Оценка сжимаемости.
+ * @throws std::runtime_error Если файл не удается прочитать.
+ */
+ProbeResult probeFile(const std::string& path, const ProbeOptions& options = {});
@@ -0,0 +1,110 @@
+#include "thread_pool.h"
+
+namespace {
+
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local unsigned current_worker = 0;
+
+}
+
+WorkStealingPool::WorkStealingPool(unsigned count) {
+    if (count == 0) count = std::thread::hardware_concurrency();
+    if (count == 0) count = 1;
+    for (unsigned i = 0; i < count; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        threads.emplace_back([this, i] { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending == 0; });
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    unsigned target = current_pool == this
+        ? current_worker
+        : static_cast<unsigned>(next_queue++ % queues.size());
+    // pending растет до того, как задачу можно взять, иначе wait() мог бы вернуться раньше ее
+    // выполнения. queued растет после вставки, чтобы разбуженный поток сразу находил задачу.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++pending;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++queued;
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending == 0; });
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+bool WorkStealingPool::tryPop(unsigned self, Task& task) {
+    {
+        WorkerQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkerQueue& victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(unsigned self) {
+    current_pool = this;
+    current_worker = self;
+    for (;;) {
+        Task task;
+        if (tryPop(self, task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --queued;
+            }
+            std::exception_ptr task_error;
+            try {
+                task(self);
+            } catch (...) {
+                task_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (task_error && !error) error = task_error;
+            if (--pending == 0) idle.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopping && queued == 0) return;
+        wake.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file thread_pool.h
+ * @brief Пул потоков с перехватом работы (work stealing).
+ */
+
+/**
+ * @class WorkStealingPool
+ * @brief Пул потоков, в котором у каждого потока своя очередь задач.
+ *
+ * Поток берет задачи из конца собственной очереди, а опустев, забирает задачи
+ * из начала очередей других потоков. Задачи, поставленные изнутри рабочего
+ * потока, попадают в его собственную очередь; внешние задачи распределяются
+ * по очередям по кругу. Каждая задача получает номер выполняющего ее потока,
+ * что позволяет держать переиспользуемое состояние отдельно для каждого потока.
+ */
+class WorkStealingPool {
+public:
+    /** @brief Задача; аргумент — номер рабочего потока в диапазоне [0, size()). */
+    using Task = std::function<void(unsigned worker)>;
+
+    /**
+     * @brief Запускает пул.
+     * @param threads Число рабочих потоков (0 — по числу аппаратных потоков).
+     */
+    explicit WorkStealingPool(unsigned threads = 0);
+
+    /**
+     * @brief Дожидается выполнения всех задач и останавливает потоки.
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Ставит задачу в очередь.
+     * @param task Задача.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Блокирует вызывающий поток до выполнения всех поставленных задач.
+     * @throws Первое исключение, выброшенное задачей, если такое было.
+     */
+    void wait();
+
+    /**
+     * @brief Возвращает число рабочих потоков.
+     * @return Число рабочих потоков.
+     */
+    unsigned size() const { return static_cast<unsigned>(threads.size()); }
+
+private:
+    /** @brief Очередь задач одного рабочего потока. */
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /** @brief Очереди задач рабочих потоков. */
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    /** @brief Рабочие потоки. */
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+
+    /**
+     * @brief Число задач, находящихся в очередях.
+     *
+     * Задача вставляется в очередь раньше, чем увеличивается счетчик, поэтому
+     * поток, укравший ее в этом промежутке, может ненадолго сделать его отрицательным.
+     */
+    std::ptrdiff_t queued = 0;
+
+    /** @brief Число поставленных, но еще не выполненных задач. */
+    size_t pending = 0;
+
+    /** @brief Признак остановки пула. */
+    bool stopping = false;
+
+    /** @brief Первое исключение, выброшенное задачей. */
+    std::exception_ptr error;
+
+    /** @brief Счетчик для распределения внешних задач по кругу. */
+    std::atomic<size_t> next_queue{0};
+
+    /**
+     * @brief Берет задачу из своей очереди или крадет из чужой.
+     * @param self Номер рабочего потока.
+     * @param task Сюда помещается найденная задача.
+     * @return true, если задача найдена.
+     */
+    bool tryPop(unsigned self, Task& task);
+
+    /**
+     * @brief Основной цикл рабочего потока.
+     * @param self Номер рабочего потока.
+     */
+    void run(unsigned self);
+};
@@ -0,0 +1,211 @@
+#include "wide_table.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t kSubtableFlag = 0x80000000u;
+
+uint64_t loadBigEndian64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+void storeBigEndian64(unsigned char* p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    std::memcpy(p, &v, sizeof(v));
+}
+
+inline unsigned wideSymbol(const unsigned char* data, size_t index) {
+    return data[2 * index] | (unsigned(data[2 * index + 1]) << 8);
+}
+
+inline unsigned decodeSymbol(const uint32_t* table, uint64_t word, unsigned char* out) {
+    uint32_t entry = table[word >> (64 - kWideRootBits)];
+    if (entry & kSubtableFlag) {
+        unsigned sub_bits = (entry >> 24) & 0xF;
+        entry = table[(entry & 0xFFFFFF) + ((word << kWideRootBits) >> (64 - sub_bits))];
+    }
+    unsigned len = (entry >> 16) & 0x1F;
+    if (len == 0) throw std::runtime_error("Corrupted block: invalid code");
+    out[0] = static_cast<unsigned char>(entry);
+    out[1] = static_cast<unsigned char>(entry >> 8);
+    return len;
+}
+
+}
+
+void countWideHistogram(const unsigned char* data, size_t size, uint64_t* counts) {
+    for (size_t i = 0; i < size / 2; ++i) counts[wideSymbol(data, i)]++;
+}
+
+WideCodeTable::WideCodeTable()
+    : freq(kWideAlphabet), lengths(kWideAlphabet), codes(kWideAlphabet), decode_table(1u << kWideRootBits) {}
+
+void WideCodeTable::buildLengths() {
+    nodes.resize(2 * kWideAlphabet - 1);
+    symbol_count = 0;
+    for (unsigned s = 0; s < kWideAlphabet; ++s) symbol_count += freq[s] != 0;
+    max_length = buildCodeLengths(freq.data(), kWideAlphabet, kMaxWideCodeLength, false, nodes.data(), lengths.data());
+}
+
+void WideCodeTable::buildCodes() {
+    unsigned length_count[kMaxWideCodeLength + 1] = {};
+    for (unsigned s = 0; s < kWideAlphabet; ++s) length_count[lengths[s]]++;
+    length_count[0] = 0;
+
+    uint64_t kraft = 0;
+    max_length = 0;
+    for (unsigned len = 1; len <= kMaxWideCodeLength; ++len) {
+        kraft += uint64_t(length_count[len]) << (kMaxWideCodeLength - len);
+        if (length_count[len]) max_length = len;
+    }
+    if (kraft > (uint64_t(1) << kMaxWideCodeLength)) throw std::runtime_error("Corrupted frequency table: invalid code lengths");
+
+    uint32_t next_code[kMaxWideCodeLength + 2] = {};
+    uint32_t code = 0;
+    for (unsigned len = 1; len <= kMaxWideCodeLength; ++len) {
+        code = (code + length_count[len - 1]) << 1;
+        next_code[len] = code;
+    }
+    for (unsigned s = 0; s < kWideAlphabet; ++s) {
+        if (lengths[s]) codes[s] = static_cast<uint16_t>(next_code[lengths[s]]++);
+    }
+
+    // Подтаблица префикса покрывает самый длинный код с этим префиксом; короткие коды в ней повторяются.
+    uint8_t sub_bits[1u << kWideRootBits] = {};
+    for (unsigned s = 0; s < kWideAlphabet; ++s) {
+        unsigned len = lengths[s];
+        if (len <= kWideRootBits) continue;
+        unsigned prefix = codes[s] >> (len - kWideRootBits);
+        sub_bits[prefix] = static_cast<uint8_t>(std::max<unsigned>(sub_bits[prefix], len - kWideRootBits));
+    }
+    uint32_t subtable_offset[1u << kWideRootBits];
+    size_t total = 1u << kWideRootBits;
+    for (unsigned prefix = 0; prefix < (1u << kWideRootBits); ++prefix) {
+        subtable_offset[prefix] = static_cast<uint32_t>(total);
+        if (sub_bits[prefix]) total += size_t(1) << sub_bits[prefix];
+    }
+    decode_table.assign(total, 0);
+    for (unsigned prefix = 0; prefix < (1u << kWideRootBits); ++prefix) {
+        if (sub_bits[prefix]) decode_table[prefix] = kSubtableFlag | (uint32_t(sub_bits[prefix]) << 24) | subtable_offset[prefix];
+    }
+
+    for (unsigned s = 0; s < kWideAlphabet; ++s) {
+        unsigned len = lengths[s];
+        if (!len) continue;
+        uint32_t entry = s | (uint32_t(len) << 16);
+        if (len <= kWideRootBits) {
+            unsigned shift = kWideRootBits - len;
+            std::fill(decode_table.begin() + (codes[s] << shift), decode_table.begin() + ((codes[s] + 1u) << shift), entry);
+        } else {
+            unsigned extra = len - kWideRootBits;
+            unsigned prefix = codes[s] >> extra;
+            unsigned shift = sub_bits[prefix] - extra;
+            uint32_t low = codes[s] & ((1u << extra) - 1);
+            auto base = decode_table.begin() + subtable_offset[prefix];
+            std::fill(base + (low << shift), base + ((low + 1) << shift), entry);
+        }
+    }
+}
+
+uint64_t WideCodeTable::encodedBits() const {
+    uint64_t bits = 0;
+    for (unsigned s = 0; s < kWideAlphabet; ++s) bits += freq[s] * lengths[s];
+    return bits;
+}
+
+size_t WideCodeTable::writeLengthTable(unsigned char* out) const {
+    frame::putU32(out, symbol_count);
+    size_t pos = 4;
+    for (unsigned s = 0; s < kWideAlphabet; ++s) {
+        if (!lengths[s]) continue;
+        out[pos] = static_cast<unsigned char>(s);
+        out[pos + 1] = static_cast<unsigned char>(s >> 8);
+        out[pos + 2] = lengths[s];
+        pos += 3;
+    }
+    return pos;
+}
+
+size_t WideCodeTable::readLengthTable(const unsigned char* in, size_t size) {
+    if (size < 4) throw std::runtime_error("Failed to read frequency table size");
+    uint32_t count = frame::getU32(in);
+    if (count == 0 || count > kWideAlphabet) throw std::runtime_error("Corrupted frequency table: invalid symbol count");
+    if (size - 4 < uint64_t(count) * 3) throw std::runtime_error("Corrupted frequency table: truncated");
+
+    std::fill(lengths.begin(), lengths.end(), 0);
+    size_t pos = 4;
+    long previous = -1;
+    for (uint32_t i = 0; i < count; ++i, pos += 3) {
+        unsigned symbol = in[pos] | (unsigned(in[pos + 1]) << 8);
+        unsigned len = in[pos + 2];
+        if (long(symbol) <= previous) throw std::runtime_error("Corrupted frequency table: duplicate symbol");
+        if (len == 0 || len > kMaxWideCodeLength) throw std::runtime_error("Corrupted frequency table: invalid code lengths");
+        lengths[symbol] = static_cast<uint8_t>(len);
+        previous = symbol;
+    }
+    symbol_count = count;
+    buildCodes();
+    return pos;
+}
+
+size_t WideCodeTable::encodeSymbols(const unsigned char* data, size_t size, unsigned char* out) const {
+    static_assert(7 + 3 * kMaxWideCodeLength <= 64, "three codes must fit into the bit accumulator");
+    const size_t symbols = size / 2;
+    unsigned char* p = out;
+    uint64_t acc = 0;
+    unsigned bits = 0;
+    size_t i = 0;
+    for (; i + 3 <= symbols; i += 3) {
+        for (unsigned k = 0; k < 3; ++k) {
+            unsigned symbol = wideSymbol(data, i + k);
+            bits += lengths[symbol];
+            acc |= uint64_t(codes[symbol]) << (64 - bits);
+        }
+        storeBigEndian64(p, acc);
+        p += bits >> 3;
+        acc <<= bits & ~7u;
+        bits &= 7;
+    }
+    for (; i < symbols; ++i) {
+        unsigned symbol = wideSymbol(data, i);
+        bits += lengths[symbol];
+        acc |= uint64_t(codes[symbol]) << (64 - bits);
+    }
+    storeBigEndian64(p, acc);
+    p += (bits + 7) >> 3;
+    return static_cast<size_t>(p - out);
+}
+
+void WideCodeTable::decodeSymbols(const unsigned char* in, size_t size, unsigned char* out, size_t raw_size) const {
+    if (symbol_count == 0) throw std::runtime_error("Archive is empty or corrupted");
+    const uint32_t* table = decode_table.data();
+    const size_t symbols = raw_size / 2;
+    size_t bit_pos = 0;
+    size_t written = 0;
+    // После чтения слова со сдвигом до 7 бит в нем не меньше 57 достоверных бит: три кода по 16.
+    while (symbols - written >= 3 && (bit_pos >> 3) + 8 <= size) {
+        uint64_t word = loadBigEndian64(in + (bit_pos >> 3)) << (bit_pos & 7);
+        for (unsigned k = 0; k < 3; ++k) {
+            unsigned len = decodeSymbol(table, word, out + 2 * (written + k));
+            word <<= len;
+            bit_pos += len;
+        }
+        written += 3;
+    }
+    for (; written < symbols; ++written) {
+        uint64_t word = 0;
+        for (size_t k = bit_pos >> 3; k < (bit_pos >> 3) + 8; ++k) word = (word << 8) | (k < size ? in[k] : 0);
+        word <<= bit_pos & 7;
+        bit_pos += decodeSymbol(table, word, out + 2 * written);
+        if (bit_pos > size * 8) throw std::runtime_error("Corrupted block: unexpected end of data");
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "block_codec.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file wide_table.h
+ * @brief Коды Хаффмана над 16-битными символами для блоков BlockMode::Wide.
+ *
+ * Данные рассматриваются как последовательность 16-битных little-endian слов, что
+ * выгодно для UTF-16 и выборок int16: зависимость между соседними байтами попадает
+ * в один символ. Таблица декодирования двухуровневая: корневая таблица на
+ * kWideRootBits бит умещается в L1, а длинные коды дочитываются из подтаблиц,
+ * размер которых определяется самым длинным кодом с данным префиксом.
+ *
+ * Полезная нагрузка блока: таблица длин (uint32 число записей, затем пары
+ * uint16 символ / uint8 длина по возрастанию символов), при нечетном raw_size —
+ * последний байт блока как есть, затем поток кодов.
+ */
+
+/** @brief Размер алфавита 16-битных символов. */
+constexpr unsigned kWideAlphabet = 65536;
+
+/** @brief Максимальная длина кода 16-битного символа. */
+constexpr unsigned kMaxWideCodeLength = 16;
+
+/** @brief Ширина индекса корневой таблицы декодирования. */
+constexpr unsigned kWideRootBits = 10;
+
+/**
+ * @brief Считает гистограмму 16-битных little-endian символов.
+ * @param data Данные (нечетный последний байт не учитывается).
+ * @param size Размер данных в байтах.
+ * @param counts Массив из kWideAlphabet счетчиков; к нему прибавляются частоты.
+ */
+void countWideHistogram(const unsigned char* data, size_t size, uint64_t* counts);
+
+/**
+ * @struct WideCodeTable
+ * @brief Канонические коды 16-битных символов с двухуровневой таблицей декодирования.
+ *
+ * Буферы выделяются один раз при создании и переиспользуются между блоками.
+ */
+struct WideCodeTable {
+    /** @brief Частоты символов (заполняются только при кодировании). */
+    std::vector<uint64_t> freq;
+
+    /** @brief Длины кодов (0 — символ отсутствует). */
+    std::vector<uint8_t> lengths;
+
+    /** @brief Канонические коды (младшие lengths[s] бит). */
+    std::vector<uint16_t> codes;
+
+    /**
+     * @brief Корневая таблица (2^kWideRootBits записей), за которой идут подтаблицы.
+     *
+     * Запись листа — символ в младших 16 битах и длина кода в битах 16–20 (0 — недопустимый
+     * префикс). Запись со старшим битом ссылается на подтаблицу: смещение в младших 24 битах,
+     * ширина индекса подтаблицы в битах 24–27.
+     */
+    std::vector<uint32_t> decode_table;
+
+    /** @brief Рабочие узлы для построения дерева (выделяются при первом buildLengths()). */
+    std::vector<Node> nodes;
+
+    /** @brief Число символов с ненулевой длиной кода. */
+    unsigned symbol_count = 0;
+
+    /** @brief Максимальная длина кода в таблице. */
+    unsigned max_length = 0;
+
+    WideCodeTable();
+
+    /** @brief Строит длины кодов по частотам. */
+    void buildLengths();
+
+    /**
+     * @brief Строит канонические коды и таблицу декодирования по длинам кодов.
+     * @throws std::runtime_error Если длины нарушают неравенство Крафта.
+     */
+    void buildCodes();
+
+    /**
+     * @brief Возвращает размер потока кодов по частотам и длинам.
+     * @return Размер в битах.
+     */
+    uint64_t encodedBits() const;
+
+    /**
+     * @brief Возвращает размер сериализованной таблицы длин.
+     * @return Размер в байтах.
+     */
+    size_t lengthTableSize() const { return 4 + symbol_count * 3; }
+
+    /**
+     * @brief Записывает таблицу длин.
+     * @param out Буфер размером не менее lengthTableSize() байт.
+     * @return Число записанных байт.
+     */
+    size_t writeLengthTable(unsigned char* out) const;
+
+    /**
+     * @brief Читает таблицу длин и строит коды и таблицу декодирования.
+     * @param in Начало таблицы.
+     * @param size Доступный размер входа.
+     * @return Число прочитанных байт.
+     * @throws std::runtime_error Если таблица повреждена.
+     */
+    size_t readLengthTable(const unsigned char* in, size_t size);
+
+    /**
+     * @brief Кодирует size / 2 символов по три за шаг с записью 64-битными словами.
+     * @param data Исходные данные.
+     * @param size Размер исходных данных в байтах (нечетный последний байт не кодируется).
+     * @param out Буфер размером не менее encodedBound(size) байт.
+     * @return Число записанных байт.
+     */
+    size_t encodeSymbols(const unsigned char* data, size_t size, unsigned char* out) const;
+
+    /**
+     * @brief Декодирует raw_size / 2 символов.
+     * @param in Поток кодов.
+     * @param size Размер потока.
+     * @param out Буфер размером не менее raw_size байт.
+     * @param raw_size Исходный размер в байтах (нечетный последний байт не декодируется).
+     * @throws std::runtime_error Если поток поврежден.
+     */
+    void decodeSymbols(const unsigned char* in, size_t size, unsigned char* out, size_t raw_size) const;
+
+    /**
+     * @brief Возвращает верхнюю границу размера потока кодов.
+     * @param size Исходный размер в байтах.
+     * @return Размер буфера для encodeSymbols().
+     */
+    static size_t encodedBound(size_t size) { return size + 8; }
+
+    /**
+     * @brief Возвращает наибольший объем памяти таблицы.
+     * @param encoder Учитывать рабочие узлы построения длин (нужны только кодировщику).
+     * @return Объем в байтах.
+     */
+    static uint64_t memorySize(bool encoder) {
+        uint64_t size = sizeof(WideCodeTable) + uint64_t(kWideAlphabet) * (8 + 1 + 2) + (uint64_t(kWideAlphabet) + (1u << kWideRootBits)) * 4;
+        return encoder ? size + (2 * uint64_t(kWideAlphabet) - 1) * sizeof(Node) : size;
+    }
+};
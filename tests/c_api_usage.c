@@ -0,0 +1,23 @@
+#include "../src/huffman_c.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Сборка этого файла компилятором C проверяет, что заголовок остается чистым C. */
+int huffCApiRoundtrip(const char* text) {
+    size_t size = strlen(text);
+    size_t bound = huff_compress_bound(size);
+    unsigned char* archive = (unsigned char*)malloc(bound);
+    char* restored = (char*)malloc(size + 1);
+    huff_ctx* ctx = huff_ctx_create();
+    size_t compressed = 0, restored_size = 0;
+    int status = HUFF_ERROR_OUT_OF_MEMORY;
+    if (archive && restored && ctx) {
+        status = huff_compress(ctx, text, size, archive, bound, 0, &compressed);
+        if (status == HUFF_OK) status = huff_decompress(ctx, archive, compressed, restored, size, &restored_size);
+        if (status == HUFF_OK && (restored_size != size || memcmp(restored, text, size) != 0)) status = HUFF_ERROR_CORRUPTED;
+    }
+    huff_ctx_free(ctx);
+    free(restored);
+    free(archive);
+    return status;
+}
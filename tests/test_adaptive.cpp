@@ -0,0 +1,120 @@
+#include "doctest.h"
+#include "../src/adaptive_stream.h"
+#include "../src/huffman.h"
+#include "../src/container.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string decodeAll(const std::string& stream) {
+    std::istringstream in(stream);
+    AdaptiveDecoder decoder(in);
+    std::string result;
+    unsigned char buffer[777];
+    while (size_t size = decoder.read(buffer, sizeof(buffer))) result.append(reinterpret_cast<const char*>(buffer), size);
+    return result;
+}
+
+}
+
+TEST_CASE("Huffman adaptive one-pass streams") {
+    std::string text;
+    for (int i = 0; i < 6000; ++i) text += "event " + std::to_string(i * 13 % 401) + (i % 3 ? " ok\n" : " retry\n");
+    for (int i = 0; i < 20000; ++i) text += static_cast<char>(i * 2654435761u >> 24);
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+
+    SUBCASE("Положительный: Поток не зависит от разбиения входа на порции") {
+        std::ostringstream whole, pieces;
+        AdaptiveEncoder first(whole, 4096);
+        first.write(data, text.size());
+        first.finish();
+        AdaptiveEncoder second(pieces, 4096);
+        for (size_t pos = 0, step = 1; pos < text.size(); pos += step, step = step * 3 % 5000 + 1) {
+            second.write(data + pos, std::min(step, text.size() - pos));
+        }
+        second.finish();
+        CHECK(whole.str() == pieces.str());
+        CHECK(decodeAll(whole.str()) == text);
+        CHECK(whole.str().size() < text.size());
+    }
+
+    SUBCASE("Положительный: После flush() получатель декодирует все отправленное") {
+        std::stringstream channel;
+        AdaptiveEncoder encoder(channel, 1024);
+        AdaptiveDecoder decoder(channel);
+        size_t sent = 0;
+        for (size_t chunk : {100u, 1u, 5000u, 923u, 7000u}) {
+            encoder.write(data + sent, chunk);
+            encoder.flush();
+            std::vector<unsigned char> received;
+            unsigned char buffer[4096];
+            while (received.size() < chunk) {
+                size_t size = decoder.read(buffer, sizeof(buffer));
+                REQUIRE(size > 0);
+                received.insert(received.end(), buffer, buffer + size);
+            }
+            CHECK(std::string(received.begin(), received.end()) == text.substr(sent, chunk));
+            sent += chunk;
+        }
+        encoder.finish();
+        unsigned char byte;
+        CHECK(decoder.read(&byte, 1) == 0);
+    }
+
+    SUBCASE("Положительный: Пустой поток") {
+        std::ostringstream out;
+        AdaptiveEncoder encoder(out);
+        encoder.finish();
+        CHECK(out.str().size() == kAdaptiveHeaderSize + frame::kBlockHeaderSize);
+        CHECK(decodeAll(out.str()).empty());
+    }
+
+    SUBCASE("Положительный: Поток и контейнер различаются по магическому числу") {
+        {
+            std::ofstream out("adaptive_magic.bin", std::ios::binary);
+            AdaptiveEncoder encoder(out);
+            encoder.write(data, 100);
+            encoder.finish();
+        }
+        ArchiveWriter("adaptive_magic.huffa").finish();
+        CHECK(AdaptiveDecoder::isAdaptiveStream("adaptive_magic.bin"));
+        CHECK_FALSE(ArchiveReader::isContainer("adaptive_magic.bin"));
+        CHECK(ArchiveReader::isContainer("adaptive_magic.huffa"));
+        CHECK_FALSE(AdaptiveDecoder::isAdaptiveStream("adaptive_magic.huffa"));
+        std::remove("adaptive_magic.bin");
+        std::remove("adaptive_magic.huffa");
+    }
+
+    SUBCASE("Отрицательный: Недопустимый интервал перестроения") {
+        std::ostringstream out;
+        CHECK_THROWS_AS(AdaptiveEncoder(out, 100), std::runtime_error);
+        CHECK_THROWS_AS(AdaptiveEncoder(out, kMaxRebuildInterval + 1), std::runtime_error);
+    }
+
+    SUBCASE("Отрицательный: Поврежденный и оборванный поток") {
+        std::ostringstream out;
+        AdaptiveEncoder encoder(out, 2048);
+        encoder.write(data, text.size());
+        encoder.finish();
+        std::string stream = out.str();
+
+        std::string corrupted = stream;
+        corrupted[stream.size() / 2] ^= 0x04;
+        CHECK_THROWS_AS(decodeAll(corrupted), std::runtime_error);
+
+        CHECK_THROWS_WITH(decodeAll(stream.substr(0, stream.size() - 1)), "Corrupted stream: unexpected end of stream");
+
+        corrupted = stream;
+        corrupted[0] = 'X';
+        CHECK_THROWS_WITH(decodeAll(corrupted), "Not an adaptive stream");
+
+        corrupted = stream;
+        frame::putU32(reinterpret_cast<unsigned char*>(&corrupted[kAdaptiveHeaderSize]), 4096);
+        CHECK_THROWS_WITH(decodeAll(corrupted), "Corrupted stream: frame crosses table rebuild");
+    }
+}
@@ -0,0 +1,56 @@
+#include "doctest.h"
+#include "../src/huffman_c.h"
+#include <string>
+#include <vector>
+
+extern "C" int huffCApiRoundtrip(const char* text);
+
+TEST_CASE("Huffman C API") {
+    std::string data;
+    for (int i = 0; i < 20000; ++i) data += "service " + std::to_string(i % 31) + " ok\n";
+    huff_ctx* ctx = huff_ctx_create();
+    REQUIRE(ctx != nullptr);
+    std::vector<unsigned char> archive(huff_compress_bound(data.size()));
+    std::vector<char> restored(data.size());
+
+    SUBCASE("Положительный: Сжатие и распаковка на всех уровнях") {
+        for (int level = 0; level <= 9; ++level) {
+            size_t compressed = 0, restored_size = 0;
+            REQUIRE(huff_compress(ctx, data.data(), data.size(), archive.data(), archive.size(), level, &compressed) == HUFF_OK);
+            CHECK(compressed < data.size());
+
+            uint64_t content_size = 0;
+            CHECK(huff_content_size(archive.data(), compressed, &content_size) == HUFF_OK);
+            CHECK(content_size == data.size());
+
+            REQUIRE(huff_decompress(ctx, archive.data(), compressed, restored.data(), restored.size(), &restored_size) == HUFF_OK);
+            CHECK(std::string(restored.data(), restored_size) == data);
+        }
+    }
+
+    SUBCASE("Положительный: Заголовок компилируется и работает из C") {
+        CHECK(huffCApiRoundtrip("hello from C") == HUFF_OK);
+    }
+
+    SUBCASE("Отрицательный: Неверные аргументы") {
+        size_t size = 0;
+        CHECK(huff_compress(nullptr, data.data(), data.size(), archive.data(), archive.size(), 0, &size) == HUFF_ERROR_INVALID_ARGUMENT);
+        CHECK(huff_compress(ctx, data.data(), 0, archive.data(), archive.size(), 0, &size) == HUFF_ERROR_INVALID_ARGUMENT);
+        CHECK(huff_compress(ctx, data.data(), data.size(), archive.data(), archive.size(), 10, &size) == HUFF_ERROR_INVALID_ARGUMENT);
+        CHECK(huff_decompress(ctx, nullptr, 10, restored.data(), restored.size(), &size) == HUFF_ERROR_INVALID_ARGUMENT);
+        CHECK(std::string(huff_status_string(HUFF_ERROR_INVALID_ARGUMENT)) == "Invalid argument");
+    }
+
+    SUBCASE("Отрицательный: Маленький буфер и поврежденный архив") {
+        size_t compressed = 0, size = 0;
+        CHECK(huff_compress(ctx, data.data(), data.size(), archive.data(), 100, 0, &size) == HUFF_ERROR_BUFFER_TOO_SMALL);
+        REQUIRE(huff_compress(ctx, data.data(), data.size(), archive.data(), archive.size(), 0, &compressed) == HUFF_OK);
+        CHECK(huff_decompress(ctx, archive.data(), compressed, restored.data(), restored.size() - 1, &size) == HUFF_ERROR_BUFFER_TOO_SMALL);
+
+        archive[compressed / 2] ^= 0x40;
+        CHECK(huff_decompress(ctx, archive.data(), compressed, restored.data(), restored.size(), &size) == HUFF_ERROR_CORRUPTED);
+        CHECK(huff_decompress(ctx, archive.data(), 5, restored.data(), restored.size(), &size) == HUFF_ERROR_CORRUPTED);
+    }
+
+    huff_ctx_free(ctx);
+}
@@ -0,0 +1,60 @@
+#include "doctest.h"
+#include "../src/huffman.h"
+#include "../src/checksum.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("Huffman integrity checksums") {
+    std::string text;
+    for (int i = 0; i < 5000; ++i) text += "line " + std::to_string(i * 31 % 977) + "\n";
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.block_size = 4096;
+    options.threads = 3;
+
+    SUBCASE("Положительный: CRC32C совпадает с эталоном и с табличной реализацией") {
+        CHECK(crc32c(0, "123456789", 9) == 0xE3069283u);
+        CHECK(crc32cSoftware(0, "123456789", 9) == 0xE3069283u);
+        CHECK(crc32c(0, data, text.size()) == crc32cSoftware(0, data, text.size()));
+        CHECK(crc32c(crc32c(0, data, 1000), data + 1000, text.size() - 1000) == crc32c(0, data, text.size()));
+    }
+
+    SUBCASE("Положительный: Суммы фрагментов объединяются в сумму целого") {
+        uint32_t first = crc32c(0, data, 1234);
+        uint32_t second = crc32c(0, data + 1234, text.size() - 1234);
+        CHECK(crc32cCombine(first, second, text.size() - 1234) == crc32c(0, data, text.size()));
+        CHECK(crc32cCombine(first, 0, 0) == first);
+        CHECK(crc32cCombine(0, second, text.size() - 1234) == second);
+    }
+
+    SUBCASE("Положительный: Проверка архива без распаковки") {
+        std::ofstream("checksum_input.txt", std::ios::binary) << text;
+        archiver.compress("checksum_input.txt", "checksum_input.huff", options);
+        CHECK(archiver.verify("checksum_input.huff", 2) == text.size());
+        fs::remove("checksum_input.txt");
+        fs::remove("checksum_input.huff");
+    }
+
+    SUBCASE("Отрицательный: Поврежденный бит обнаруживается при проверке и распаковке") {
+        options.seek_index = false;
+        std::vector<unsigned char> compressed = archiver.compressBuffer(data, text.size(), options);
+        std::vector<unsigned char> corrupted = compressed;
+        corrupted[corrupted.size() / 2] ^= 0x10;
+        CHECK_THROWS_AS(archiver.decompressBuffer(corrupted.data(), corrupted.size()), std::runtime_error);
+
+        std::ofstream("checksum_corrupted.huff", std::ios::binary).write(reinterpret_cast<const char*>(corrupted.data()), corrupted.size());
+        CHECK_THROWS_AS(archiver.verify("checksum_corrupted.huff", 2), std::runtime_error);
+        fs::remove("checksum_corrupted.huff");
+
+        corrupted = compressed;
+        corrupted[corrupted.size() - 1] ^= 0x01;
+        CHECK_THROWS_WITH_AS(archiver.decompressBuffer(corrupted.data(), corrupted.size()), "Corrupted archive: content checksum mismatch", std::runtime_error);
+    }
+}
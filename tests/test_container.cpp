@@ -0,0 +1,157 @@
+#include "doctest.h"
+#include "../src/container.h"
+#include "../src/block_codec.h"
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("Huffman multi-file container") {
+    std::string archive = "test_container.huffa";
+    std::vector<std::pair<std::string, std::string>> files = {
+        {"container_a.txt", "hello world"},
+        {"container_b.txt", std::string(5000, 'x') + "tail"},
+        {"container_empty.txt", ""},
+    };
+    for (const auto& file : files) {
+        std::ofstream out(file.first, std::ios::binary);
+        out << file.second;
+    }
+
+    CompressOptions options;
+    options.block_size = 1024;
+    {
+        ArchiveWriter writer(archive);
+        for (const auto& file : files) writer.add(file.first, "dir/" + file.first, options);
+        writer.finish();
+    }
+
+    SUBCASE("Положительный: Каталог читается и каждый член извлекается отдельно") {
+        ArchiveReader reader(archive);
+        REQUIRE(reader.getEntries().size() == files.size());
+        CHECK(ArchiveReader::isContainer(archive));
+        for (const auto& file : files) {
+            const ArchiveEntry* entry = reader.find("dir/" + file.first);
+            REQUIRE(entry != nullptr);
+            CHECK(entry->size == file.second.size());
+            reader.extract(*entry, "container_out.txt");
+            CHECK(readFile("container_out.txt") == file.second);
+        }
+    }
+
+    SUBCASE("Положительный: Диапазон члена извлекается без распаковки всего члена") {
+        ArchiveReader reader(archive);
+        CHECK(reader.extractRange("dir/container_b.txt", 4990, 100, "container_out.txt") == 14);
+        CHECK(readFile("container_out.txt") == files[1].second.substr(4990));
+    }
+
+    SUBCASE("Положительный: Извлечение всех членов воссоздает каталоги") {
+        ArchiveReader(archive).extractAll("container_out_dir");
+        for (const auto& file : files) {
+            CHECK(readFile("container_out_dir/dir/" + file.first) == file.second);
+        }
+    }
+
+    SUBCASE("Отрицательный: Отсутствующий член и небезопасное имя") {
+        ArchiveReader reader(archive);
+        CHECK(reader.find("missing.txt") == nullptr);
+        CHECK_THROWS_AS(reader.extract("missing.txt", "container_out.txt"), std::runtime_error);
+
+        ArchiveWriter writer("test_container_bad.huffa");
+        CHECK_THROWS_AS(writer.add(files[0].first, "../escape.txt"), std::runtime_error);
+        CHECK_THROWS_AS(writer.add(files[0].first, "/abs.txt"), std::runtime_error);
+    }
+
+    SUBCASE("Отрицательный: Непустой член без сжатого содержимого") {
+        std::string bytes = readFile(archive);
+        auto* data = reinterpret_cast<unsigned char*>(&bytes[0]);
+        // Запись каталога: длина имени (2), имя, размер (8), режим (4), mtime (8), смещение (8), сжатый размер (8).
+        auto fields = [&](size_t pos) { return pos + 2 + (data[pos] | data[pos + 1] << 8); };
+        size_t first = static_cast<size_t>(frame::getU64(data + bytes.size() - 16));
+        size_t second = fields(first) + 36;
+        frame::putU64(data + fields(second) + 28, 0);
+        std::ofstream("test_container_bad.huffa", std::ios::binary) << bytes;
+        CHECK_THROWS_WITH(ArchiveReader("test_container_bad.huffa"), "Corrupted archive: member size mismatch");
+    }
+
+    SUBCASE("Отрицательный: Обычный архив не является контейнером") {
+        HuffmanArchiver().compress(files[0].first, "container_plain.huff");
+        CHECK_FALSE(ArchiveReader::isContainer("container_plain.huff"));
+        CHECK_THROWS_AS(ArchiveReader("container_plain.huff"), std::runtime_error);
+    }
+
+    for (const auto& file : files) fs::remove(file.first);
+    for (const auto& path : {archive, std::string("container_out.txt"), std::string("test_container_bad.huffa"), std::string("container_plain.huff")}) {
+        fs::remove(path);
+    }
+    fs::remove_all("container_out_dir");
+}
+
+TEST_CASE("Huffman directory tree container") {
+    std::vector<std::pair<std::string, std::string>> files = {
+        {"a.txt", "top level"},
+        {"sub/b.txt", std::string(3000, 'b') + "end"},
+        {"sub/deep/c.txt", ""},
+        {"sub/deep/large.bin", std::string(20000, 'q') + "large tail"},
+        {"z/d.txt", "last"},
+    };
+    for (const auto& file : files) {
+        fs::path path = fs::path("tree_input") / file.first;
+        fs::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary) << file.second;
+    }
+    fs::create_directories("tree_input/empty_dir");
+    fs::permissions("tree_input/a.txt", fs::perms::owner_read | fs::perms::owner_write);
+    auto mtime = fs::last_write_time("tree_input/sub/b.txt");
+
+    CompressOptions options;
+    options.block_size = 4096;
+    options.threads = 3;
+
+    SUBCASE("Положительный: Обход возвращает относительные пути по порядку") {
+        std::vector<TreeFile> found = walkTree("tree_input", 2);
+        REQUIRE(found.size() == files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            CHECK(found[i].name == files[i].first);
+            CHECK(found[i].size == files[i].second.size());
+        }
+    }
+
+    SUBCASE("Положительный: Дерево упаковывается и восстанавливается с правами и временем") {
+        {
+            ArchiveWriter writer("tree.huffa");
+            writer.addTree("tree_input", options);
+            writer.finish();
+        }
+        ArchiveReader reader("tree.huffa");
+        REQUIRE(reader.getEntries().size() == files.size());
+        reader.extractAll("tree_output", 2);
+        for (const auto& file : files) {
+            CHECK(readFile("tree_output/" + file.first) == file.second);
+        }
+        CHECK((fs::status("tree_output/a.txt").permissions() & fs::perms::all) == (fs::perms::owner_read | fs::perms::owner_write));
+        auto restored = fs::last_write_time("tree_output/sub/b.txt");
+        CHECK(std::chrono::floor<std::chrono::seconds>(restored.time_since_epoch()) ==
+              std::chrono::floor<std::chrono::seconds>(mtime.time_since_epoch()));
+        reader.verify(2);
+    }
+
+    SUBCASE("Отрицательный: Корень не является каталогом, имя повторяется") {
+        CHECK_THROWS_AS(walkTree("tree_input/a.txt"), std::runtime_error);
+        ArchiveWriter writer("tree.huffa");
+        writer.add("tree_input/a.txt", "a.txt", options);
+        CHECK_THROWS_WITH(writer.addTree("tree_input", options), "Duplicate member name: a.txt");
+    }
+
+    fs::remove_all("tree_input");
+    fs::remove_all("tree_output");
+    fs::remove("tree.huffa");
+}
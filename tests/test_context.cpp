@@ -0,0 +1,102 @@
+#include "doctest.h"
+#include "../src/huffman_context.h"
+#include "../src/dictionary.h"
+#include "../src/huffman.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::atomic<size_t> allocation_count{0};
+
+void* operator new(std::size_t size) {
+    allocation_count++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+TEST_CASE("Huffman context without steady-state allocations") {
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += "record " + std::to_string(i * 7919 % 1000) + " status=ok\n";
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+
+    CompressOptions options;
+    options.block_size = 4096;
+    std::vector<unsigned char> compressed(HuffmanContext::compressBound(text.size(), options.block_size));
+    std::vector<unsigned char> restored(text.size());
+    HuffmanContext context;
+
+    SUBCASE("Положительный: Повторные вызовы не выделяют память") {
+        size_t compressed_size = context.compress(data, text.size(), compressed.data(), compressed.size(), options);
+        context.decompress(compressed.data(), compressed_size, restored.data(), restored.size());
+
+        size_t before = allocation_count;
+        for (int i = 0; i < 50; ++i) {
+            compressed_size = context.compress(data, text.size(), compressed.data(), compressed.size(), options);
+            size_t restored_size = context.decompress(compressed.data(), compressed_size, restored.data(), restored.size());
+            CHECK(restored_size == text.size());
+        }
+        CHECK(allocation_count - before == 0);
+        CHECK(std::string(restored.begin(), restored.end()) == text);
+        CHECK(HuffmanContext::contentSize(compressed.data(), compressed_size) == text.size());
+    }
+
+    SUBCASE("Положительный: Архив из одного блока записывается без индекса") {
+        CompressOptions single = options;
+        single.block_size = text.size();
+        single.adaptive_split = false;
+        size_t single_size = context.compress(data, text.size(), compressed.data(), compressed.size(), single);
+        CHECK((frame::readHeader(compressed.data()).flags & (frame::kFlagIndex | frame::kFlagSingleBlock)) == frame::kFlagSingleBlock);
+        CHECK(HuffmanContext::contentSize(compressed.data(), single_size) == text.size());
+        size_t restored_size = context.decompress(compressed.data(), single_size, restored.data(), restored.size());
+        CHECK(std::string(restored.begin(), restored.begin() + restored_size) == text);
+
+        size_t compressed_size = context.compress(data, text.size(), compressed.data(), compressed.size(), options);
+        CHECK((frame::readHeader(compressed.data()).flags & frame::kFlagIndex) != 0);
+        CHECK(single_size + frame::indexSize(1) < compressed_size);
+    }
+
+    SUBCASE("Отрицательный: Недостаточный выходной буфер") {
+        CHECK_THROWS_AS(context.compress(data, text.size(), compressed.data(), 16, options), std::runtime_error);
+
+        size_t compressed_size = context.compress(data, text.size(), compressed.data(), compressed.size(), options);
+        CHECK_THROWS_AS(context.decompress(compressed.data(), compressed_size, restored.data(), text.size() - 1), std::runtime_error);
+    }
+}
+
+TEST_CASE("Huffman pipeline allocations do not grow with input size") {
+    struct NullBuffer : std::streambuf {
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    CompressOptions options;
+    options.threads = 2;
+    options.block_size = 1 << 16;
+    options.seek_index = false;
+    HuffmanArchiver archiver;
+
+    auto countAllocations = [&](size_t runs) {
+        std::string text;
+        for (int i = 0; text.size() < runs << 20; ++i) text += "event " + std::to_string(i * 7919 % 4093) + " done\n";
+        text.resize(runs << 20);
+        std::istringstream in(text);
+        NullBuffer sink;
+        std::ostream out(&sink);
+        size_t before = allocation_count;
+        archiver.compressStream(in, out, options);
+        return allocation_count - before;
+    };
+
+    SUBCASE("Положительный: Число выделений памяти не зависит от числа блоков") {
+        size_t small = countAllocations(8);
+        size_t large = countAllocations(32);
+        CHECK(large <= small + 4);
+    }
+}
@@ -0,0 +1,53 @@
+#include "doctest.h"
+#include "../src/huffman.h"
+#include "../src/checksum.h"
+#include "../src/cpu_dispatch.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("Huffman CPU kernel dispatch") {
+    std::string text;
+    for (int i = 0; i < 20000; ++i) text += "kernel " + std::to_string(i * 7919 % 104729) + (i % 5 ? " " : "\n");
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    const KernelSet detected = detectKernelSet();
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.block_size = 16 * 1024;
+    options.threads = 2;
+
+    SUBCASE("Положительный: Все поддерживаемые наборы дают одинаковый архив") {
+        std::vector<unsigned char> reference = archiver.compressBuffer(data, text.size(), options);
+        for (KernelSet set : {KernelSet::Generic, KernelSet::Sse42, KernelSet::Avx2}) {
+            if (!kernelSetSupported(set)) continue;
+            CAPTURE(kernelSetName(set));
+            setKernelSet(set);
+            CHECK(activeKernelSet() == set);
+            CHECK(crc32cHardware() == (set != KernelSet::Generic));
+            CHECK(crc32c(0, "123456789", 9) == 0xE3069283u);
+            std::vector<unsigned char> archive = archiver.compressBuffer(data, text.size(), options);
+            CHECK(archive == reference);
+            std::vector<unsigned char> restored = archiver.decompressBuffer(archive.data(), archive.size());
+            CHECK(std::string(restored.begin(), restored.end()) == text);
+        }
+        setKernelSet(detected);
+    }
+
+    SUBCASE("Положительный: Имена наборов разбираются обратно") {
+        CHECK(kernelSetSupported(KernelSet::Generic));
+        CHECK(kernelSetSupported(detected));
+        CHECK(parseKernelSet("auto") == detected);
+        for (KernelSet set : {KernelSet::Generic, KernelSet::Sse42, KernelSet::Avx2}) {
+            CHECK(parseKernelSet(kernelSetName(set)) == set);
+        }
+    }
+
+    SUBCASE("Отрицательный: Неизвестное имя и неподдерживаемый набор") {
+        CHECK_THROWS_AS(parseKernelSet("neon"), std::runtime_error);
+        if (!kernelSetSupported(KernelSet::Avx2)) {
+            CHECK_THROWS_AS(setKernelSet(KernelSet::Avx2), std::runtime_error);
+            CHECK(activeKernelSet() == detected);
+        }
+    }
+}
@@ -1,10 +1,16 @@
 #include "doctest.h"
 #include "../src/huffman.h"
+#include "../src/dictionary.h"
+#include "../src/block_codec.h"
+#include "../src/wide_table.h"
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
 #include <filesystem>
 #include <map>
+#include <memory>
+#include <sstream>
 #include <iostream>
 
 namespace fs = std::filesystem;
@@ -140,4 +146,805 @@ TEST_CASE("Huffman tree building") {
 
         cleanup_files({test_input, test_compressed});
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Huffman pipelined block compression") {
+    std::string test_input = "test_input.bin";
+    std::string test_compressed = "test_compressed.huff";
+    std::string test_decompressed = "test_decompressed.bin";
+
+    std::string data;
+    uint32_t state = 12345;
+    for (int i = 0; i < 200000; ++i) {
+        state = state * 1103515245 + 12345;
+        data += static_cast<char>(i < 100000 ? 'a' + (state >> 16) % 8 : (state >> 16) & 0xFF);
+    }
+    std::ofstream out(test_input, std::ios::binary);
+    out << data;
+    out.close();
+
+    HuffmanArchiver archiver;
+
+    SUBCASE("Положительный: Несколько блоков и несколько потоков") {
+        CompressOptions options;
+        options.threads = 3;
+        options.block_size = 4096;
+        archiver.compress(test_input, test_compressed, options);
+        archiver.decompress(test_compressed, test_decompressed);
+
+        std::ifstream in_decomp(test_decompressed, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in_decomp)), std::istreambuf_iterator<char>());
+        in_decomp.close();
+        CHECK(content == data);
+        CHECK(fs::file_size(test_compressed) < data.size());
+    }
+
+    SUBCASE("Положительный: Файл из одного повторяющегося символа") {
+        std::ofstream single(test_input, std::ios::binary | std::ios::trunc);
+        single << std::string(10000, 'z');
+        single.close();
+
+        archiver.compress(test_input, test_compressed);
+        archiver.decompress(test_compressed, test_decompressed);
+
+        std::ifstream in_decomp(test_decompressed, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in_decomp)), std::istreambuf_iterator<char>());
+        in_decomp.close();
+        CHECK(content == std::string(10000, 'z'));
+    }
+
+    SUBCASE("Положительный: Диапазон извлекается по индексу блоков и без него") {
+        CompressOptions options;
+        options.threads = 2;
+        options.block_size = 4096;
+        for (bool seek_index : {true, false}) {
+            options.seek_index = seek_index;
+            archiver.compress(test_input, test_compressed, options);
+            for (uint64_t offset : {0, 4095, 4096, 123457, 199990}) {
+                uint64_t written = archiver.extractRange(test_compressed, offset, 10000, test_decompressed);
+                std::ifstream in_range(test_decompressed, std::ios::binary);
+                std::string content((std::istreambuf_iterator<char>(in_range)), std::istreambuf_iterator<char>());
+                CHECK(written == content.size());
+                CHECK(content == data.substr(offset, 10000));
+            }
+        }
+    }
+
+    SUBCASE("Отрицательный: Диапазон за концом содержимого") {
+        archiver.compress(test_input, test_compressed);
+        CHECK_THROWS_AS(archiver.extractRange(test_compressed, data.size(), 10, test_decompressed), std::runtime_error);
+    }
+
+    SUBCASE("Отрицательный: Ошибка чтения не оставляет корректный архив") {
+        // Источник отдает три прогона данных, после чего чтение завершается ошибкой.
+        struct FailingBuffer : std::streambuf {
+            std::string chunk = std::string(1 << 16, 'q');
+            size_t left = 48;
+            int_type underflow() override {
+                if (left-- == 0) throw std::runtime_error("device error");
+                setg(&chunk[0], &chunk[0], &chunk[0] + chunk.size());
+                return traits_type::to_int_type(chunk[0]);
+            }
+        };
+        CompressOptions options;
+        options.threads = 2;
+        options.block_size = 4096;
+        FailingBuffer buffer;
+        std::istream in(&buffer);
+        std::ostringstream out;
+        CHECK_THROWS_WITH(archiver.compressStream(in, out, options), "Failed to read input file");
+        std::string archive = out.str();
+        CHECK_THROWS_WITH(archiver.decompressBuffer(reinterpret_cast<const unsigned char*>(archive.data()), archive.size()),
+                          "Corrupted archive: missing end of archive marker");
+    }
+
+    SUBCASE("Отрицательный: Нулевой размер блока") {
+        CompressOptions options;
+        options.block_size = 0;
+        CHECK_THROWS_AS(archiver.compress(test_input, test_compressed, options), std::runtime_error);
+        options.block_size = size_t(frame::kMaxBlockSize) + 1;
+        CHECK_THROWS_WITH(archiver.compress(test_input, test_compressed, options), "Invalid block size");
+    }
+
+    cleanup_files({test_input, test_compressed, test_decompressed});
+}
+
+TEST_CASE("Huffman adaptive block splitting") {
+    std::string data;
+    for (int i = 0; i < 3000; ++i) data += "entry " + std::to_string(i) + " ok\n";
+    uint32_t state = 777;
+    for (int i = 0; i < 60000; ++i) {
+        state = state * 1103515245 + 12345;
+        data += static_cast<char>(0x80 + ((state >> 16) & 0x7F));
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.block_size = data.size();
+
+    SUBCASE("Положительный: Разнородные данные делятся на блоки и сжимаются лучше") {
+        options.adaptive_split = false;
+        std::vector<unsigned char> fixed = archiver.compressBuffer(bytes, data.size(), options);
+        options.adaptive_split = true;
+        std::vector<unsigned char> adaptive = archiver.compressBuffer(bytes, data.size(), options);
+        CHECK(adaptive.size() < fixed.size());
+
+        std::vector<unsigned char> restored = archiver.decompressBuffer(adaptive.data(), adaptive.size());
+        CHECK(std::string(restored.begin(), restored.end()) == data);
+    }
+
+    SUBCASE("Положительный: Однородные данные не разбиваются") {
+        std::string uniform(200000, 'a');
+        for (size_t i = 0; i < uniform.size(); i += 3) uniform[i] = 'b';
+        options.seek_index = false;
+        options.adaptive_split = false;
+        std::vector<unsigned char> fixed = archiver.compressBuffer(reinterpret_cast<const unsigned char*>(uniform.data()), uniform.size(), options);
+        options.adaptive_split = true;
+        std::vector<unsigned char> adaptive = archiver.compressBuffer(reinterpret_cast<const unsigned char*>(uniform.data()), uniform.size(), options);
+        CHECK(adaptive.size() == fixed.size());
+    }
+}
+
+TEST_CASE("Huffman compression levels") {
+    std::string data;
+    uint32_t state = 4242;
+    for (int part = 0; part < 6; ++part) {
+        for (int i = 0; i < 2000; ++i) data += "level " + std::to_string(i % 50) + " line\n";
+        for (int i = 0; i < 20000; ++i) {
+            state = state * 1103515245 + 12345;
+            data += static_cast<char>(0x80 + ((state >> 16) & 0x3F));
+        }
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    HuffmanArchiver archiver;
+
+    SUBCASE("Положительный: Все уровни восстанавливают данные, старшие сжимают лучше младших") {
+        std::vector<size_t> sizes(10);
+        for (int level = 1; level <= 9; ++level) {
+            std::vector<unsigned char> compressed = archiver.compressBuffer(bytes, data.size(), CompressOptions::fromLevel(level));
+            std::vector<unsigned char> restored = archiver.decompressBuffer(compressed.data(), compressed.size());
+            CHECK(std::string(restored.begin(), restored.end()) == data);
+            sizes[level] = compressed.size();
+        }
+        CHECK(sizes[6] < sizes[2]);
+        CHECK(sizes[9] < sizes[2]);
+    }
+
+    SUBCASE("Положительный: Уровень 6 совпадает с параметрами по умолчанию") {
+        CompressOptions level = CompressOptions::fromLevel(6);
+        CompressOptions defaults;
+        CHECK(level.block_size == defaults.block_size);
+        CHECK(level.adaptive_split == defaults.adaptive_split);
+        CHECK(level.split_segment == defaults.split_segment);
+        CHECK(level.optimal_lengths == defaults.optimal_lengths);
+    }
+
+    SUBCASE("Положительный: Package-merge дает оптимальные длины в пределах ограничения") {
+        CodeTable heuristic, optimal;
+        uint64_t a = 1, b = 1;
+        for (int s = 0; s < 40; ++s) {
+            heuristic.freq[s] = optimal.freq[s] = a;
+            uint64_t next = a + b;
+            a = b;
+            b = next;
+        }
+        optimal.optimal_lengths = true;
+        heuristic.build();
+        optimal.build();
+        CHECK(optimal.max_length <= kMaxCodeLength);
+        CHECK(optimal.encodedBits() <= heuristic.encodedBits());
+
+        uint32_t kraft = 0;
+        for (int s = 0; s < 256; ++s) {
+            if (optimal.lengths[s]) kraft += 1u << (kMaxCodeLength - optimal.lengths[s]);
+        }
+        CHECK(kraft <= (1u << kMaxCodeLength));
+
+        std::map<unsigned char, std::string> codes = optimal.toCodeMap();
+        CHECK(codes.size() == 40);
+    }
+
+    SUBCASE("Отрицательный: Уровень вне диапазона") {
+        CHECK_THROWS_AS(CompressOptions::fromLevel(0), std::runtime_error);
+        CHECK_THROWS_AS(CompressOptions::fromLevel(10), std::runtime_error);
+    }
+}
+
+TEST_CASE("Huffman code table reuse") {
+    std::string test_input = "test_reuse.txt";
+    std::string test_compressed = "test_reuse.huff";
+    std::string test_range = "test_reuse_range.txt";
+
+    std::string data;
+    for (int i = 0; data.size() < 300000; ++i) data += "GET /api/items/" + std::to_string(i % 97) + " 200\n";
+    std::ofstream(test_input, std::ios::binary) << data;
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.block_size = 4096;
+    options.threads = 2;
+    options.adaptive_split = false;
+
+    SUBCASE("Положительный: Блоки со стабильным распределением переиспользуют таблицу") {
+        std::vector<unsigned char> compressed = archiver.compressBuffer(reinterpret_cast<const unsigned char*>(data.data()), data.size(), options);
+        size_t repeat_blocks = 0, blocks = 0;
+        size_t pos = frame::headerSize(frame::readHeader(compressed.data()).flags);
+        for (frame::BlockHeader block = frame::readBlockHeader(compressed.data() + pos); block.raw_size != 0;
+             block = frame::readBlockHeader(compressed.data() + pos)) {
+            blocks++;
+            if (block.mode == frame::BlockMode::Repeat) repeat_blocks++;
+            pos += frame::kBlockHeaderSize + block.payload_size;
+        }
+        CHECK(blocks > 1);
+        CHECK(repeat_blocks == blocks - 1);
+
+        std::vector<unsigned char> restored = archiver.decompressBuffer(compressed.data(), compressed.size());
+        CHECK(std::string(restored.begin(), restored.end()) == data);
+    }
+
+    SUBCASE("Положительный: Проверка и произвольный доступ с блоками Repeat") {
+        archiver.compress(test_input, test_compressed, options);
+        CHECK(archiver.verify(test_compressed, 2) == data.size());
+
+        for (uint64_t offset : {0, 5000, 150001, 299000}) {
+            archiver.extractRange(test_compressed, offset, 3000, test_range);
+            std::ifstream in_range(test_range, std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(in_range)), std::istreambuf_iterator<char>());
+            CHECK(content == data.substr(offset, 3000));
+        }
+
+        archiver.decompress(test_compressed, test_range);
+        std::ifstream in_full(test_range, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in_full)), std::istreambuf_iterator<char>());
+        CHECK(content == data);
+    }
+
+    cleanup_files({test_input, test_compressed, test_range});
+}
+
+TEST_CASE("Huffman decoder kernels") {
+    // Фибоначчиевы частоты дают максимальную длину кода, равную числу символов минус один;
+    // множитель задает число символов в блоке, от которого зависит ширина таблицы.
+    auto makeTable = [](unsigned symbols, uint64_t scale = 1 << 20) {
+        auto table = std::make_unique<CodeTable>();
+        uint64_t a = 1, b = 1;
+        for (unsigned s = 0; s < symbols; ++s) {
+            table->freq[s] = a * scale;
+            uint64_t next = a + b;
+            a = b;
+            b = next;
+        }
+        table->build();
+        return table;
+    };
+    auto makeData = [](const CodeTable& table, size_t size) {
+        std::vector<unsigned char> data;
+        for (unsigned s = 0; data.size() < size; s = (s * 7 + 3) % 256) {
+            if (table.lengths[s]) data.push_back(static_cast<unsigned char>(s));
+        }
+        return data;
+    };
+
+    SUBCASE("Положительный: Каждая ширина таблицы декодирует свой поток") {
+        for (unsigned symbols : {2u, 8u, 10u, 11u, 12u, 13u}) {
+            auto table = makeTable(symbols);
+            unsigned expected = table->max_length <= 8 ? 8 : table->max_length <= 10 ? 10 : table->max_length;
+            CHECK(table->table_bits == expected);
+            for (size_t size : {1u, 7u, 1000u}) {
+                std::vector<unsigned char> data = makeData(*table, size);
+                std::vector<unsigned char> encoded(CodeTable::encodedBound(size));
+                size_t encoded_size = table->encodeBits(data.data(), size, encoded.data());
+                std::vector<unsigned char> restored(size);
+                table->decodeBits(encoded.data(), encoded_size, restored.data(), size);
+                CHECK(restored == data);
+            }
+        }
+    }
+
+    SUBCASE("Положительный: Маленький блок декодируется 8-битной таблицей с дочитыванием длинных кодов") {
+        for (unsigned symbols : {10u, 12u, 13u}) {
+            auto table = makeTable(symbols, 1);
+            REQUIRE(table->max_length > 8);
+            CHECK(table->table_bits == 8);
+            std::vector<unsigned char> data = makeData(*table, 1000);
+            // Самые редкие символы с самыми длинными кодами — в начале, середине и конце потока.
+            data[0] = data[500] = data[999] = 0;
+            std::vector<unsigned char> encoded(CodeTable::encodedBound(data.size()));
+            for (size_t size : {1u, 7u, 1000u}) {
+                size_t encoded_size = table->encodeBits(data.data(), size, encoded.data());
+                std::vector<unsigned char> restored(size);
+                table->decodeBits(encoded.data(), encoded_size, restored.data(), size);
+                CHECK(std::equal(restored.begin(), restored.end(), data.begin()));
+            }
+        }
+    }
+
+    SUBCASE("Отрицательный: Поток короче заявленного размера") {
+        for (unsigned symbols : {8u, 12u, 13u}) {
+            auto table = makeTable(symbols, 1);
+            std::vector<unsigned char> data = makeData(*table, 1000);
+            std::vector<unsigned char> encoded(CodeTable::encodedBound(data.size()));
+            size_t encoded_size = table->encodeBits(data.data(), data.size(), encoded.data());
+            std::vector<unsigned char> restored(data.size());
+            CHECK_THROWS_WITH(table->decodeBits(encoded.data(), encoded_size / 2, restored.data(), restored.size()),
+                              "Corrupted block: unexpected end of data");
+        }
+    }
+
+    SUBCASE("Отрицательный: Декодирование останавливается сразу за концом потока") {
+        for (unsigned symbols : {8u, 12u, 13u}) {
+            auto table = makeTable(symbols, 1);
+            const unsigned char encoded[2] = {0x5A, 0xC3};
+            // Каждый код занимает хотя бы бит, поэтому из двух байтов декодируется не больше 17 символов.
+            std::vector<unsigned char> restored(1 << 20, 0xEE);
+            CHECK_THROWS_WITH(table->decodeBits(encoded, sizeof(encoded), restored.data(), restored.size()),
+                              "Corrupted block: unexpected end of data");
+            CHECK(std::all_of(restored.begin() + 17, restored.end(), [](unsigned char c) { return c == 0xEE; }));
+        }
+    }
+}
+
+TEST_CASE("Huffman word encoder") {
+    CodeTable table;
+    uint64_t a = 1, b = 1;
+    for (int s = 0; s < 13; ++s) {
+        table.freq['a' + s] = a;
+        uint64_t next = a + b;
+        a = b;
+        b = next;
+    }
+    table.build();
+    REQUIRE(table.max_length == kMaxCodeLength);
+    std::map<unsigned char, std::string> codes = table.toCodeMap();
+
+    SUBCASE("Положительный: Поток совпадает с побитовой записью кодов при любой длине хвоста") {
+        std::string text = "mlkjihgfedcbaammmlmlkabcdefghijklm";
+        for (size_t size = 0; size <= text.size(); ++size) {
+            std::string bits;
+            for (size_t i = 0; i < size; ++i) bits += codes[static_cast<unsigned char>(text[i])];
+            std::vector<unsigned char> expected((bits.size() + 7) / 8, 0);
+            for (size_t i = 0; i < bits.size(); ++i) {
+                if (bits[i] == '1') expected[i / 8] |= static_cast<unsigned char>(0x80 >> (i % 8));
+            }
+
+            std::vector<unsigned char> encoded(CodeTable::encodedBound(size), 0xAA);
+            size_t encoded_size = table.encodeBits(reinterpret_cast<const unsigned char*>(text.data()), size, encoded.data());
+            CAPTURE(size);
+            REQUIRE(encoded_size == expected.size());
+            CHECK(std::vector<unsigned char>(encoded.begin(), encoded.begin() + encoded_size) == expected);
+        }
+    }
+}
+
+TEST_CASE("Huffman 16-bit symbols") {
+    std::vector<unsigned char> utf16;
+    for (int i = 0; i < 40000; ++i) {
+        unsigned symbol = i % 7 == 6 ? 0x20 : 0x430 + (i * 2654435761u >> 16) % 24;
+        utf16.push_back(static_cast<unsigned char>(symbol));
+        utf16.push_back(static_cast<unsigned char>(symbol >> 8));
+    }
+    utf16.push_back('!');
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.seek_index = false;
+    options.adaptive_split = false;
+
+    SUBCASE("Положительный: UTF-16 сжимается лучше побайтового кодирования") {
+        std::vector<unsigned char> bytes = archiver.compressBuffer(utf16.data(), utf16.size(), options);
+        options.wide_symbols = true;
+        std::vector<unsigned char> wide = archiver.compressBuffer(utf16.data(), utf16.size(), options);
+        const size_t block = frame::headerSize(frame::readHeader(wide.data()).flags);
+        CHECK(frame::readBlockHeader(wide.data() + block).mode == frame::BlockMode::Wide);
+        CHECK(wide.size() < bytes.size());
+        CHECK(archiver.decompressBuffer(wide.data(), wide.size()) == utf16);
+    }
+
+    SUBCASE("Положительный: Двухуровневая таблица декодирует коды длиннее корневой") {
+        WideCodeTable table;
+        uint64_t a = 1, b = 1;
+        for (unsigned s = 0; s < 300; ++s) {
+            table.freq[s * 211] = s < 40 ? a : 1;
+            if (s < 40) {
+                uint64_t next = a + b;
+                a = b;
+                b = next;
+            }
+        }
+        table.buildLengths();
+        table.buildCodes();
+        CHECK(table.max_length == kMaxWideCodeLength);
+        CHECK(table.decode_table.size() > (1u << kWideRootBits));
+
+        std::vector<unsigned char> data;
+        for (unsigned i = 0; i < 3001; ++i) {
+            unsigned symbol = (i * 37 % 300) * 211;
+            data.push_back(static_cast<unsigned char>(symbol));
+            data.push_back(static_cast<unsigned char>(symbol >> 8));
+        }
+        std::vector<unsigned char> encoded(WideCodeTable::encodedBound(data.size()));
+        size_t encoded_size = table.encodeSymbols(data.data(), data.size(), encoded.data());
+        std::vector<unsigned char> serialized(table.lengthTableSize());
+        table.writeLengthTable(serialized.data());
+
+        WideCodeTable decoder;
+        CHECK(decoder.readLengthTable(serialized.data(), serialized.size()) == serialized.size());
+        std::vector<unsigned char> restored(data.size());
+        decoder.decodeSymbols(encoded.data(), encoded_size, restored.data(), restored.size());
+        CHECK(restored == data);
+    }
+
+    SUBCASE("Отрицательный: Поврежденная таблица длин") {
+        options.wide_symbols = true;
+        std::vector<unsigned char> archive = archiver.compressBuffer(utf16.data(), utf16.size(), options);
+        const size_t table = frame::headerSize(frame::readHeader(archive.data()).flags) + frame::kBlockHeaderSize;
+
+        std::vector<unsigned char> corrupted = archive;
+        corrupted[table + 4 + 3] = corrupted[table + 4];
+        corrupted[table + 4 + 4] = corrupted[table + 4 + 1];
+        CHECK_THROWS_WITH(archiver.decompressBuffer(corrupted.data(), corrupted.size()), "Corrupted frequency table: duplicate symbol");
+
+        corrupted = archive;
+        corrupted[table + 4 + 2] = 1;
+        corrupted[table + 4 + 5] = 1;
+        CHECK_THROWS_WITH(archiver.decompressBuffer(corrupted.data(), corrupted.size()), "Corrupted frequency table: invalid code lengths");
+    }
+}
+
+TEST_CASE("Huffman stored and RLE blocks") {
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.block_size = 16384;
+    options.seek_index = false;
+
+    SUBCASE("Положительный: Несжимаемые данные почти не увеличиваются") {
+        std::string data;
+        uint32_t state = 99;
+        for (int i = 0; i < 100000; ++i) {
+            state = state * 1664525 + 1013904223;
+            data += static_cast<char>(state >> 24);
+        }
+        std::vector<unsigned char> compressed = archiver.compressBuffer(reinterpret_cast<const unsigned char*>(data.data()), data.size(), options);
+        size_t blocks = (data.size() + options.block_size - 1) / options.block_size;
+        CHECK(compressed.size() <= data.size() + frame::kMaxHeaderSize + (blocks + 1) * frame::kBlockHeaderSize);
+
+        std::vector<unsigned char> restored = archiver.decompressBuffer(compressed.data(), compressed.size());
+        CHECK(std::string(restored.begin(), restored.end()) == data);
+    }
+
+    SUBCASE("Положительный: Блок из одного символа занимает один байт") {
+        std::string data(100000, 'q');
+        std::vector<unsigned char> compressed = archiver.compressBuffer(reinterpret_cast<const unsigned char*>(data.data()), data.size(), options);
+        size_t blocks = (data.size() + options.block_size - 1) / options.block_size;
+        size_t header_size = frame::headerSize(frame::readHeader(compressed.data()).flags);
+        CHECK(compressed.size() == header_size + blocks * (frame::kBlockHeaderSize + 1) + frame::kBlockHeaderSize);
+
+        std::vector<unsigned char> restored = archiver.decompressBuffer(compressed.data(), compressed.size());
+        CHECK(std::string(restored.begin(), restored.end()) == data);
+    }
+
+    SUBCASE("Отрицательный: Поврежденный размер блока Stored") {
+        std::string data(1000, 'a');
+        for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 131 + (i >> 3));
+        std::vector<unsigned char> compressed = archiver.compressBuffer(reinterpret_cast<const unsigned char*>(data.data()), data.size(), options);
+        size_t pos = frame::headerSize(frame::readHeader(compressed.data()).flags);
+        REQUIRE(frame::readBlockHeader(compressed.data() + pos).mode == frame::BlockMode::Stored);
+        compressed[pos] ^= 0x01;
+        CHECK_THROWS_AS(archiver.decompressBuffer(compressed.data(), compressed.size()), std::runtime_error);
+    }
+}
+
+TEST_CASE("Huffman decoder hardening") {
+    std::string data;
+    for (int i = 0; i < 200; ++i) data += "hardening " + std::to_string(i % 7) + "\n";
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.block_size = 4096;
+    options.seek_index = false;
+    std::vector<unsigned char> archive = archiver.compressBuffer(reinterpret_cast<const unsigned char*>(data.data()), data.size(), options);
+    const size_t block = frame::headerSize(frame::readHeader(archive.data()).flags);
+    const size_t table = block + frame::kBlockHeaderSize;
+    REQUIRE(frame::readBlockHeader(archive.data() + block).mode == frame::BlockMode::Huffman);
+
+    auto expectRejected = [&](std::vector<unsigned char> corrupted, const char* message) {
+        CHECK_THROWS_AS(archiver.decompressBuffer(corrupted.data(), corrupted.size()), std::runtime_error);
+        std::istringstream in(std::string(corrupted.begin(), corrupted.end()));
+        CHECK_THROWS_WITH(archiver.verifyStream(in, 1), message);
+    };
+
+    SUBCASE("Отрицательный: Больше 256 символов в таблице частот") {
+        std::vector<unsigned char> corrupted = archive;
+        frame::putU32(corrupted.data() + table, 300);
+        expectRejected(corrupted, "Corrupted frequency table: invalid symbol count");
+    }
+
+    SUBCASE("Отрицательный: Повторяющийся символ") {
+        std::vector<unsigned char> corrupted = archive;
+        corrupted[table + 4 + 9] = corrupted[table + 4];
+        expectRejected(corrupted, "Corrupted frequency table: duplicate symbol");
+    }
+
+    SUBCASE("Отрицательный: Нулевая частота") {
+        std::vector<unsigned char> corrupted = archive;
+        frame::putU64(corrupted.data() + table + 5, 0);
+        expectRejected(corrupted, "Corrupted frequency table: zero frequency");
+    }
+
+    SUBCASE("Отрицательный: Переполнение суммы частот") {
+        std::vector<unsigned char> corrupted = archive;
+        frame::putU64(corrupted.data() + table + 5, UINT64_MAX);
+        expectRejected(corrupted, "Corrupted frequency table: frequency overflow");
+    }
+
+    SUBCASE("Отрицательный: Сумма частот не равна размеру блока") {
+        std::vector<unsigned char> corrupted = archive;
+        frame::putU64(corrupted.data() + table + 5, frame::getU64(corrupted.data() + table + 5) + 1);
+        expectRejected(corrupted, "Corrupted block: frequency table does not match block size");
+    }
+
+    SUBCASE("Отрицательный: Блок больше размера блока архива") {
+        std::vector<unsigned char> corrupted = archive;
+        frame::putU32(corrupted.data() + block, 4097);
+        expectRejected(corrupted, "Corrupted block: block is larger than archive block size");
+    }
+
+    SUBCASE("Отрицательный: Полезная нагрузка больше возможной") {
+        std::vector<unsigned char> corrupted = archive;
+        frame::putU32(corrupted.data() + block + 5, 0xFFFFFFF0u);
+        expectRejected(corrupted, "Corrupted block: payload is too large");
+    }
+
+    SUBCASE("Отрицательный: Полезная нагрузка короче бита на символ") {
+        std::vector<unsigned char> corrupted = archive;
+        frame::putU32(corrupted.data() + block + 5, 1);
+        expectRejected(corrupted, "Corrupted block: payload is too small");
+    }
+
+    SUBCASE("Отрицательный: Размер блока архива больше предела декодера") {
+        for (uint32_t block_size : {0u, frame::kMaxBlockSize + 1, UINT32_MAX}) {
+            std::vector<unsigned char> corrupted = archive;
+            frame::putU32(corrupted.data() + 6, block_size);
+            expectRejected(corrupted, "Corrupted archive: invalid block size");
+        }
+    }
+}
+
+TEST_CASE("Huffman content size in header") {
+    std::string test_input = "test_sized.txt";
+    std::string test_compressed = "test_sized.huff";
+    std::string test_decompressed = "test_sized_out.txt";
+
+    std::string data;
+    for (int i = 0; data.size() < 3000000; ++i) data += "record " + std::to_string(i * 7919 % 100003) + "\n";
+    std::ofstream(test_input, std::ios::binary) << data;
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.threads = 2;
+    options.block_size = 1 << 16;
+
+    auto readFile = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+
+    SUBCASE("Положительный: Размер записан в заголовок, файл распаковывается в заранее выделенный вывод") {
+        archiver.compress(test_input, test_compressed, options);
+        std::string archive = readFile(test_compressed);
+        frame::Header header = frame::readHeader(reinterpret_cast<const unsigned char*>(archive.data()));
+        frame::readHeaderExtension(header, reinterpret_cast<const unsigned char*>(archive.data()) + frame::kHeaderSize);
+        REQUIRE((header.flags & frame::kFlagContentSize) != 0);
+        CHECK(header.content_size == data.size());
+
+        std::ofstream(test_decompressed, std::ios::binary) << std::string(5000000, 'x');
+        archiver.decompress(test_compressed, test_decompressed);
+        CHECK(readFile(test_decompressed) == data);
+    }
+
+    SUBCASE("Положительный: Поток без перемотки сжимается без размера в заголовке") {
+        struct PipeBuffer : std::streambuf {
+            explicit PipeBuffer(std::string& bytes) { setg(&bytes[0], &bytes[0], &bytes[0] + bytes.size()); }
+        };
+        PipeBuffer buffer(data);
+        std::istream in(&buffer);
+        std::ostringstream out;
+        archiver.compressStream(in, out, options);
+        std::string archive = out.str();
+        CHECK((frame::readHeader(reinterpret_cast<const unsigned char*>(archive.data())).flags & frame::kFlagContentSize) == 0);
+
+        std::ofstream(test_compressed, std::ios::binary) << archive;
+        archiver.decompress(test_compressed, test_decompressed);
+        CHECK(readFile(test_decompressed) == data);
+    }
+
+    SUBCASE("Отрицательный: Размер в заголовке не совпадает с содержимым") {
+        archiver.compress(test_input, test_compressed, options);
+        std::string archive = readFile(test_compressed);
+        for (uint64_t content_size : {uint64_t(data.size() - 1), uint64_t(data.size() + 1), uint64_t(1) << 50}) {
+            frame::putU64(reinterpret_cast<unsigned char*>(&archive[frame::kHeaderSize]), content_size);
+            std::ofstream(test_compressed, std::ios::binary | std::ios::trunc) << archive;
+            CHECK_THROWS_WITH(archiver.decompress(test_compressed, test_decompressed), "Corrupted archive: content size mismatch");
+            CHECK_THROWS_AS(archiver.verify(test_compressed), std::runtime_error);
+            CHECK(fs::file_size(test_decompressed) <= data.size());
+        }
+    }
+
+    SUBCASE("Отрицательный: Огромный размер блока в заголовке не резервирует вывод") {
+        archiver.compress(test_input, test_compressed, options);
+        std::string archive = readFile(test_compressed);
+        frame::putU32(reinterpret_cast<unsigned char*>(&archive[6]), UINT32_MAX);
+        frame::putU64(reinterpret_cast<unsigned char*>(&archive[frame::kHeaderSize]), uint64_t(1) << 40);
+        std::ofstream(test_compressed, std::ios::binary | std::ios::trunc) << archive;
+        std::ofstream(test_decompressed, std::ios::binary | std::ios::trunc);
+        CHECK_THROWS_WITH(archiver.decompress(test_compressed, test_decompressed), "Corrupted archive: invalid block size");
+        CHECK(fs::file_size(test_decompressed) == 0);
+    }
+
+    cleanup_files({test_input, test_compressed, test_decompressed});
+}
+
+TEST_CASE("Huffman multi-file compression") {
+    std::vector<std::string> inputs = {"many_0.txt", "many_1.txt", "many_2.txt", "many_large.txt"};
+    std::vector<std::string> contents;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        std::string text;
+        // Большой файл занимает несколько прогонов, чтобы они записывались через окно по порядку.
+        size_t repeat = i + 1 == inputs.size() ? 250000 : i + 1;
+        for (size_t j = 0; j < repeat; ++j) text += "file " + std::to_string(i) + " line " + std::to_string(j) + "\n";
+        std::ofstream out(inputs[i], std::ios::binary);
+        out << text;
+        contents.push_back(text);
+    }
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.threads = 2;
+    options.block_size = 4096;
+
+    SUBCASE("Положительный: Маленькие файлы пакетами и большой файл по блокам") {
+        std::vector<FileError> errors = archiver.compressMany(inputs, options);
+        CHECK(errors.empty());
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            archiver.decompress(inputs[i] + ".huff", "many_out.txt");
+            std::ifstream in("many_out.txt", std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            CHECK(content == contents[i]);
+        }
+    }
+
+    SUBCASE("Отрицательный: Несуществующий файл не прерывает остальные") {
+        std::vector<std::string> with_missing = inputs;
+        with_missing.insert(with_missing.begin() + 1, "non_existent.txt");
+        std::vector<FileError> errors = archiver.compressMany(with_missing, options);
+        REQUIRE(errors.size() == 1);
+        CHECK(errors[0].path == "non_existent.txt");
+        for (const auto& input : inputs) CHECK(fs::exists(input + ".huff"));
+    }
+
+    for (const auto& input : inputs) cleanup_files({input, input + ".huff"});
+    cleanup_files({"many_out.txt"});
+}
+
+TEST_CASE("Huffman dictionaries for small payloads") {
+    std::string sample = "dict_sample.txt";
+    std::string dictionary_file = "test.dict";
+    std::string corpus;
+    for (int i = 0; i < 200; ++i) corpus += "{\"user\":" + std::to_string(i) + ",\"event\":\"click\",\"ok\":true}\n";
+    std::ofstream out(sample, std::ios::binary);
+    out << corpus;
+    out.close();
+
+    std::string message = "{\"user\":4242,\"event\":\"click\",\"ok\":true}\n{\"user\":7,\"event\":\"click\",\"ok\":false}\n";
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(message.data());
+
+    auto dictionary = std::make_shared<const Dictionary>(Dictionary::train({sample}));
+    HuffmanArchiver archiver;
+    archiver.addDictionary(dictionary);
+
+    SUBCASE("Положительный: Сообщение со словарем меньше исходного и меньше без словаря") {
+        CompressOptions options;
+        options.dictionary = dictionary;
+        std::vector<unsigned char> with_dictionary = archiver.compressBuffer(data, message.size(), options);
+        std::vector<unsigned char> without_dictionary = archiver.compressBuffer(data, message.size());
+        CHECK(with_dictionary.size() < message.size());
+        CHECK(with_dictionary.size() < without_dictionary.size());
+
+        std::vector<unsigned char> restored = archiver.decompressBuffer(with_dictionary.data(), with_dictionary.size());
+        CHECK(std::string(restored.begin(), restored.end()) == message);
+    }
+
+    SUBCASE("Положительный: Архив из одного блока читается всеми путями распаковки") {
+        CompressOptions options;
+        options.dictionary = dictionary;
+        std::vector<unsigned char> compressed = archiver.compressBuffer(data, message.size(), options);
+        CHECK((frame::readHeader(compressed.data()).flags & frame::kFlagSingleBlock) != 0);
+        std::ofstream("dict_message.huff", std::ios::binary).write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+
+        archiver.decompress("dict_message.huff", "dict_message.txt");
+        std::ifstream in("dict_message.txt", std::ios::binary);
+        CHECK(std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()) == message);
+        CHECK(archiver.verify("dict_message.huff") == message.size());
+        CHECK(archiver.extractRange("dict_message.huff", 40, 20, "dict_message.txt") == 20);
+
+        compressed[40] ^= 0x40;
+        CHECK_THROWS_AS(archiver.decompressBuffer(compressed.data(), compressed.size()), std::runtime_error);
+        compressed.pop_back();
+        CHECK_THROWS_AS(archiver.decompressBuffer(compressed.data(), compressed.size()), std::runtime_error);
+    }
+
+    SUBCASE("Положительный: Словарь сохраняется и загружается с тем же идентификатором") {
+        dictionary->save(dictionary_file);
+        Dictionary loaded = Dictionary::load(dictionary_file);
+        CHECK(loaded.getId() == dictionary->getId());
+        CHECK(loaded.getTable().toCodeMap() == dictionary->getTable().toCodeMap());
+    }
+
+    SUBCASE("Отрицательный: Архив ссылается на незарегистрированный словарь") {
+        CompressOptions options;
+        options.dictionary = dictionary;
+        std::vector<unsigned char> compressed = archiver.compressBuffer(data, message.size(), options);
+        HuffmanArchiver other;
+        CHECK_THROWS_AS(other.decompressBuffer(compressed.data(), compressed.size()), std::runtime_error);
+    }
+
+    cleanup_files({sample, dictionary_file, "dict_message.huff", "dict_message.txt"});
+}
+
+TEST_CASE("Huffman batch compression") {
+    std::vector<std::string> records;
+    for (int i = 0; i < 3000; ++i) {
+        records.push_back("{\"user\":" + std::to_string(i * 7 % 1009) + ",\"event\":\"" + (i % 3 ? "click" : "view") + "\"}");
+    }
+    records.push_back(std::string(300000, 'x') + "tail");
+    records.push_back("z");
+    std::vector<BatchInput> inputs;
+    for (const auto& record : records) inputs.push_back({reinterpret_cast<const unsigned char*>(record.data()), record.size()});
+
+    HuffmanArchiver archiver;
+    CompressOptions options;
+    options.seek_index = false;
+    options.threads = 2;
+
+    auto checkOutput = [&](const BatchOutput& output) {
+        REQUIRE(output.offsets.size() == records.size() + 1);
+        CHECK(output.offsets.front() == 0);
+        CHECK(output.offsets.back() == output.arena.size());
+        HuffmanArchiver reader;
+        if (output.dictionary) reader.addDictionary(output.dictionary);
+        for (size_t i = 0; i < records.size(); ++i) {
+            REQUIRE(output.offsets[i] < output.offsets[i + 1]);
+            std::vector<unsigned char> restored = reader.decompressBuffer(output.arena.data() + output.offsets[i], output.offsets[i + 1] - output.offsets[i]);
+            CHECK(std::string(restored.begin(), restored.end()) == records[i]);
+        }
+    };
+
+    SUBCASE("Положительный: Каждая запись совпадает с отдельным compressBuffer()") {
+        for (unsigned threads : {1u, 2u}) {
+            options.threads = threads;
+            BatchOutput output;
+            archiver.compressBatch(inputs.data(), inputs.size(), &output, options);
+            CHECK(output.dictionary == nullptr);
+            checkOutput(output);
+            for (size_t i : {size_t(0), size_t(1234), records.size() - 2, records.size() - 1}) {
+                std::vector<unsigned char> single = archiver.compressBuffer(inputs[i].data, inputs[i].size, options);
+                CHECK(std::equal(single.begin(), single.end(), output.arena.begin() + output.offsets[i], output.arena.begin() + output.offsets[i + 1]));
+            }
+        }
+    }
+
+    SUBCASE("Положительный: Общая таблица на пакет уменьшает результат") {
+        BatchOutput separate, shared;
+        archiver.compressBatch(inputs.data(), inputs.size(), &separate, options);
+        archiver.compressBatch(inputs.data(), inputs.size(), &shared, options, true);
+        REQUIRE(shared.dictionary != nullptr);
+        CHECK(shared.arena.size() < separate.arena.size());
+        checkOutput(shared);
+    }
+
+    SUBCASE("Отрицательный: Пустая запись и отсутствующий результат") {
+        BatchOutput output;
+        inputs[5].size = 0;
+        CHECK_THROWS_WITH(archiver.compressBatch(inputs.data(), inputs.size(), &output, options), "Batch record 5 is empty");
+        CHECK_THROWS_AS(archiver.compressBatch(inputs.data(), inputs.size(), nullptr, options), std::runtime_error);
+    }
+}
@@ -0,0 +1,49 @@
+#include "doctest.h"
+#include "../src/probe.h"
+#include "../src/huffman.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("Huffman compressibility probe") {
+    std::string text;
+    for (int i = 0; text.size() < 2000000; ++i) text += "user=" + std::to_string(i % 1000) + " action=login status=ok\n";
+    std::string noise;
+    uint32_t state = 5;
+    for (int i = 0; i < 2000000; ++i) {
+        state = state * 1664525 + 1013904223;
+        noise += static_cast<char>(state >> 24);
+    }
+
+    SUBCASE("Положительный: Оценка близка к фактическому размеру сжатого текста") {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+        ProbeResult result = probe(data, text.size());
+        CHECK(result.size == text.size());
+        CHECK(result.sampled < text.size());
+        CHECK(result.ratio < 0.8);
+
+        std::vector<unsigned char> compressed = HuffmanArchiver().compressBuffer(data, text.size());
+        double actual = static_cast<double>(compressed.size());
+        CHECK(std::abs(result.estimated_size - actual) / actual < 0.1);
+    }
+
+    SUBCASE("Положительный: Несжимаемые данные и файл") {
+        std::ofstream("probe_noise.bin", std::ios::binary) << noise;
+        ProbeResult result = probeFile("probe_noise.bin");
+        CHECK(result.ratio >= 1.0);
+        CHECK(result.entropy > 7.9);
+        fs::remove("probe_noise.bin");
+    }
+
+    SUBCASE("Отрицательный: Пустые данные и несуществующий файл") {
+        ProbeResult result = probe(nullptr, 0);
+        CHECK(result.estimated_size == 0);
+        CHECK(result.ratio == 1.0);
+        CHECK_THROWS_AS(probeFile("probe_missing.bin"), std::runtime_error);
+    }
+}